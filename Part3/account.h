@@ -1,15 +1,15 @@
 #ifndef ACCOUNT_H_
 #define ACCOUNT_H_
 #include <pthread.h>
+#include "money.h"
 
+// Cold identity data, read only once the header is loaded. The balance,
+// transaction tracter and lock live in account_state (account_store.h).
 typedef struct
 {
 char account_number[17];
 char password[20];
-double balance;
-double reward_rate;
-double transaction_tracter;
+rate_t reward_rate;
 char out_file[64];
-pthread_mutex_t ac_lock;
-} account;
+}Account;
 #endif /* ACCOUNT_H_ */
@@ -0,0 +1,34 @@
+#ifndef ACCOUNT_HEADER_H_
+#define ACCOUNT_HEADER_H_
+
+#include <stddef.h>
+#include "account.h"
+#include "money.h"
+
+#define HEADER_MIN_BLOCKS_PER_THREAD 16384  // below this a thread costs more than it parses
+
+//the account header of an input file, mapped so the account blocks can be
+//parsed without stdio and split between threads
+typedef struct
+{
+    const char* data;
+    size_t size;
+    int num_accounts;
+    size_t first_block;         // offset of the first "index" line
+    size_t body;                // offset of the first transaction line, set by account_header_parse
+}account_header;
+
+//maps path and reads the account count, returns 0 on success
+int account_header_open(account_header* header, const char* path);
+
+//parses every account block into accounts[N] (N being the block's "index N"),
+//balances go to balance with balance_stride bytes between accounts so they can
+//live in the account or in separate hot state. Uses up to num_threads threads.
+//Returns 0 on success, -1 if a block is malformed or the header does not hold
+//exactly num_accounts blocks.
+int account_header_parse(account_header* header, Account* accounts, money_t* balance,
+                         size_t balance_stride, int num_threads);
+
+void account_header_close(account_header* header);
+
+#endif /* ACCOUNT_HEADER_H_ */
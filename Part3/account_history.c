@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include "account_history.h"
+
+#define HISTORY_LINE "Current Savings Balance  "
+
+static void lru_unlink(account_history* history, int slot)
+{
+    history_file* file = &history->files[slot];
+
+    if (file->prev >= 0) history->files[file->prev].next = file->next;
+    else history->lru_first = file->next;
+    if (file->next >= 0) history->files[file->next].prev = file->prev;
+    else history->lru_last = file->prev;
+}
+
+static void lru_push_front(account_history* history, int slot)
+{
+    history_file* file = &history->files[slot];
+
+    file->prev = -1;
+    file->next = history->lru_first;
+    if (history->lru_first >= 0) history->files[history->lru_first].prev = slot;
+    else history->lru_last = slot;
+    history->lru_first = slot;
+}
+
+// Closes the least recently used file, returns -1 if closing reported an error
+static int evict_file(account_history* history)
+{
+    int slot = history->lru_last;
+    history_file* file = &history->files[slot];
+
+    lru_unlink(history, slot);
+    history->open_slot[file->account] = -1;
+    history->free_slots[history->num_free_slots++] = slot;
+    history->num_open--;
+    return close(file->fd);
+}
+
+// Returns a descriptor appending to the account's history file, opening it and
+// closing the least recently used one if the limit is reached. The first open
+// creates the file.
+static int history_fd(account_history* history, int account, int* failed)
+{
+    int slot = history->open_slot[account];
+
+    if (slot >= 0) {
+        lru_unlink(history, slot);
+        lru_push_front(history, slot);
+        return history->files[slot].fd;
+    }
+
+    if (history->num_open >= history->max_open && evict_file(history) != 0) {
+        *failed = 1;
+    }
+    int flags = O_WRONLY | (history->started[account] ? O_APPEND : O_CREAT | O_TRUNC);
+    int fd = open(history->accounts[account].out_file, flags, 0666);
+    while (fd == -1 && (errno == EMFILE || errno == ENFILE) && history->num_open > 0) {
+        // descriptors opened elsewhere took the room, hold fewer files from now on
+        history->max_open = history->num_open;
+        if (evict_file(history) != 0) {
+            *failed = 1;
+        }
+        fd = open(history->accounts[account].out_file, flags, 0666);
+    }
+    if (fd == -1) {
+        return -1;
+    }
+
+    slot = history->free_slots[--history->num_free_slots];
+    history->files[slot] = (history_file){account, fd, -1, -1};
+    lru_push_front(history, slot);
+    history->open_slot[account] = slot;
+    history->num_open++;
+    history->started[account] = 1;
+    return fd;
+}
+
+static int write_all(int fd, const char* text, size_t length)
+{
+    while (length > 0) {
+        ssize_t written = write(fd, text, length);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        text += written;
+        length -= written;
+    }
+    return 0;
+}
+
+// Appends the pending snapshots to every file with one write per account.
+// Passes alternate direction, so with more accounts than open files the files
+// used last in one pass are still open at the start of the next.
+static int append_pending(account_history* history)
+{
+    char* text = history->text;
+    int count = history->num_pending;
+    int failed = 0;
+
+    for (int n = 0; n < history->num_accounts && !failed; n++) {
+        int account = history->reverse ? history->num_accounts - 1 - n : n;
+        size_t length = 0;
+
+        if (!history->started[account]) {
+            length += sprintf(text, "account: %d\n", account);
+        }
+        for (int k = 0; k < count; k++) {
+            memcpy(text + length, HISTORY_LINE, sizeof(HISTORY_LINE) - 1);
+            length += sizeof(HISTORY_LINE) - 1;
+            length += money_format(text + length, history->pending[(size_t)k * history->num_accounts + account]);
+            text[length++] = '\n';
+        }
+
+        int fd = history_fd(history, account, &failed);
+        if (fd == -1 || write_all(fd, text, length) != 0) {
+            failed = 1;
+        }
+    }
+    history->reverse = !history->reverse;
+    history->num_pending = 0;
+    return failed ? -1 : 0;
+}
+
+static void* write_history(void* arg)
+{
+    account_history* history = (account_history*)arg;
+    size_t snapshot_size = (size_t)history->num_accounts * sizeof(money_t);
+    int failed = 0;
+
+    pthread_mutex_lock(&history->lock);
+    while (1) {
+        while (history->queued == 0 && !history->finishing) {
+            pthread_cond_wait(&history->submitted, &history->lock);
+        }
+        if (history->queued == 0) {
+            break;
+        }
+        money_t* snapshot = history->queue[history->head];
+        history->head = (history->head + 1) % HISTORY_QUEUE_DEPTH;
+        history->queued--;
+        pthread_mutex_unlock(&history->lock);
+
+        // after a failure snapshots are only handed back so the bank never waits
+        if (history->num_pending == history->max_pending && !failed && append_pending(history) != 0) {
+            failed = 1;
+        }
+        if (!failed) {
+            memcpy(history->pending + (size_t)history->num_pending * history->num_accounts, snapshot, snapshot_size);
+            history->num_pending++;
+        }
+
+        pthread_mutex_lock(&history->lock);
+        history->free_buffers[history->num_free++] = snapshot;
+        pthread_cond_signal(&history->released);
+    }
+    pthread_mutex_unlock(&history->lock);
+
+    if (!failed && history->num_pending > 0 && append_pending(history) != 0) {
+        failed = 1;
+    }
+    while (history->num_open > 0) {
+        if (evict_file(history) != 0) {
+            failed = 1;
+        }
+    }
+    history->failed = failed;
+    return NULL;
+}
+
+int account_history_start(account_history* history, Account* accounts, int num_accounts, const char* dir)
+{
+    struct rlimit limit;
+
+    memset(history, 0, sizeof(*history));
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    for (int i = 0; i < num_accounts; i++) {
+        int length = snprintf(accounts[i].out_file, sizeof(accounts[i].out_file), "%s/act_%d.txt", dir, i);
+        if (length >= (int)sizeof(accounts[i].out_file)) {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+    }
+
+    history->max_open = HISTORY_MAX_OPEN_FILES;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY &&
+        limit.rlim_cur / 2 < (rlim_t)history->max_open) {
+        history->max_open = limit.rlim_cur / 2; // leave half for the rest of the process
+    }
+    if (history->max_open < 1) {
+        history->max_open = 1;
+    }
+
+    size_t count = num_accounts > 0 ? num_accounts : 1;
+    history->max_pending = HISTORY_PENDING_BYTES / (count * sizeof(money_t));
+    if (history->max_pending > HISTORY_MAX_PENDING) history->max_pending = HISTORY_MAX_PENDING;
+    if (history->max_pending < 1) history->max_pending = 1;
+
+    history->accounts = accounts;
+    history->num_accounts = num_accounts;
+    history->open_slot = malloc(count * sizeof(int));
+    history->started = calloc(count, 1);
+    history->files = malloc(history->max_open * sizeof(history_file));
+    history->free_slots = malloc(history->max_open * sizeof(int));
+    history->pending = malloc(history->max_pending * count * sizeof(money_t));
+    history->text = malloc(32 + history->max_pending * (sizeof(HISTORY_LINE) + MONEY_TEXT_MAX));
+    int allocated = history->open_slot != NULL && history->started != NULL && history->files != NULL &&
+                    history->free_slots != NULL && history->pending != NULL && history->text != NULL;
+    for (int k = 0; k < HISTORY_QUEUE_DEPTH; k++) {
+        history->buffers[k] = malloc(count * sizeof(money_t));
+        history->free_buffers[k] = history->buffers[k];
+        allocated = allocated && history->buffers[k] != NULL;
+    }
+    if (!allocated) {
+        for (int k = 0; k < HISTORY_QUEUE_DEPTH; k++) {
+            free(history->buffers[k]);
+        }
+        free(history->text);
+        free(history->pending);
+        free(history->free_slots);
+        free(history->files);
+        free(history->started);
+        free(history->open_slot);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    for (int i = 0; i < num_accounts; i++) {
+        history->open_slot[i] = -1;
+    }
+    for (int s = 0; s < history->max_open; s++) {
+        history->free_slots[s] = s;
+    }
+    history->num_free_slots = history->max_open;
+    history->num_free = HISTORY_QUEUE_DEPTH;
+    history->lru_first = history->lru_last = -1;
+
+    pthread_mutex_init(&history->lock, NULL);
+    pthread_cond_init(&history->submitted, NULL);
+    pthread_cond_init(&history->released, NULL);
+    pthread_create(&history->thread, NULL, write_history, history);
+    return 0;
+}
+
+money_t* account_history_acquire(account_history* history)
+{
+    pthread_mutex_lock(&history->lock);
+    while (history->num_free == 0) {
+        pthread_cond_wait(&history->released, &history->lock);
+    }
+    money_t* balances = history->free_buffers[--history->num_free];
+    pthread_mutex_unlock(&history->lock);
+    return balances;
+}
+
+void account_history_submit(account_history* history, money_t* balances)
+{
+    pthread_mutex_lock(&history->lock);
+    history->queue[(history->head + history->queued) % HISTORY_QUEUE_DEPTH] = balances;
+    history->queued++;
+    pthread_cond_signal(&history->submitted);
+    pthread_mutex_unlock(&history->lock);
+}
+
+int account_history_finish(account_history* history)
+{
+    pthread_mutex_lock(&history->lock);
+    history->finishing = 1;
+    pthread_cond_signal(&history->submitted);
+    pthread_mutex_unlock(&history->lock);
+    pthread_join(history->thread, NULL);
+
+    pthread_cond_destroy(&history->released);
+    pthread_cond_destroy(&history->submitted);
+    pthread_mutex_destroy(&history->lock);
+    for (int k = 0; k < HISTORY_QUEUE_DEPTH; k++) {
+        free(history->buffers[k]);
+    }
+    free(history->text);
+    free(history->pending);
+    free(history->free_slots);
+    free(history->files);
+    free(history->started);
+    free(history->open_slot);
+    return history->failed ? -1 : 0;
+}
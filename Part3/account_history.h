@@ -0,0 +1,84 @@
+#ifndef ACCOUNT_HISTORY_H_
+#define ACCOUNT_HISTORY_H_
+
+#include <pthread.h>
+#include "account.h"
+#include "money.h"
+
+#define HISTORY_QUEUE_DEPTH 4           // snapshot buffers the bank can fill ahead of the writer
+#define HISTORY_MAX_OPEN_FILES 256      // history files kept open at once, fewer if RLIMIT_NOFILE is low
+#define HISTORY_MAX_PENDING 256         // snapshots the writer holds before appending them
+
+// memory the writer may hold in pending snapshots, with more accounts it
+// appends more often
+#ifndef HISTORY_PENDING_BYTES
+#define HISTORY_PENDING_BYTES (64 << 20)
+#endif
+
+//a history file the writer holds open, linked into its least recently used list
+typedef struct
+{
+    int account;
+    int fd;
+    int prev;
+    int next;
+}history_file;
+
+//per-account balance history files, "account: N" followed by one
+//"Current Savings Balance  <balance>" line per snapshot, written to each
+//account's out_file by a background thread. The bank fills a snapshot buffer
+//and submits it, the writer copies it and hands the buffer back. Copies pile up
+//until HISTORY_PENDING_BYTES or HISTORY_MAX_PENDING are reached, then every
+//file gets all of them in one write, so a file is opened once per pass rather
+//than once per snapshot.
+typedef struct
+{
+    Account* accounts;
+    int num_accounts;
+
+    pthread_mutex_t lock;
+    pthread_cond_t submitted;
+    pthread_cond_t released;
+    money_t* buffers[HISTORY_QUEUE_DEPTH];
+    money_t* queue[HISTORY_QUEUE_DEPTH];    // filled snapshots, oldest at head
+    int head;
+    int queued;
+    money_t* free_buffers[HISTORY_QUEUE_DEPTH];
+    int num_free;
+    int finishing;
+    int failed;
+    pthread_t thread;
+
+    // owned by the writer thread
+    money_t* pending;                       // pending snapshot k is pending[k * num_accounts ...]
+    int max_pending;
+    int num_pending;
+    char* text;                             // one account's lines of a pass
+    int* open_slot;                         // per account, its slot in files or -1
+    char* started;                          // per account, whether the file was created
+    history_file* files;
+    int* free_slots;                        // slots of files not holding a file
+    int num_free_slots;
+    int max_open;
+    int num_open;
+    int lru_first;                          // most recently used
+    int lru_last;
+    int reverse;                            // direction of the next pass over the accounts
+}account_history;
+
+//names every account's out_file dir/act_N.txt, creating dir if needed, and
+//starts the writer thread. Returns 0 on success, -1 with errno set.
+int account_history_start(account_history* history, Account* accounts, int num_accounts, const char* dir);
+
+//waits for a free snapshot buffer of num_accounts balances, which only blocks
+//when the writer is HISTORY_QUEUE_DEPTH snapshots behind
+money_t* account_history_acquire(account_history* history);
+
+//queues a buffer from account_history_acquire to be appended to the files
+void account_history_submit(account_history* history, money_t* balances);
+
+//writes everything submitted, stops the writer and closes every file.
+//Returns 0 if every write succeeded, -1 otherwise.
+int account_history_finish(account_history* history);
+
+#endif /* ACCOUNT_HISTORY_H_ */
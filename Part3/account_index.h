@@ -0,0 +1,30 @@
+#ifndef ACCOUNT_INDEX_H_
+#define ACCOUNT_INDEX_H_
+
+#include "account.h"
+
+typedef struct
+{
+    unsigned int hash;      // full hash of the account number, 0 marks an empty slot
+    int account;            // position in the accounts array
+}index_slot;
+
+typedef struct
+{
+    index_slot* slots;
+    unsigned int mask;      // table size - 1, table size is a power of two
+    Account* accounts;
+}account_index;
+
+//builds an open-addressing hash table over the account numbers so a lookup
+//costs the same no matter how many accounts were loaded, returns 0 on success
+int account_index_build(account_index* index, Account* accounts, int num_accounts);
+
+//returns the position of the account in the accounts array, or -1 when the
+//account number is unknown
+int account_index_find(const account_index* index, const char* account_number);
+
+//releases the slot table, the accounts array is not touched
+void account_index_free(account_index* index);
+
+#endif /* ACCOUNT_INDEX_H_ */
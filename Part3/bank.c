@@ -2,91 +2,258 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <time.h>
 #include "account.h"
+#include "account_header.h"
+#include "account_history.h"
+#include "account_index.h"
+#include "account_store.h"
+#include "cpu_topology.h"
+#include "delta_batch.h"
+#include "input_reader.h"
+#include "output_writer.h"
+#include "phase_timer.h"
 #include "string_parser.h"
+#include "transaction.h"
+#include "txn_counter.h"
 
-#define NUM_WORKERS 10
 #define TRANSACTION_THRESHOLD 5000
 
 typedef struct {
-    account *accounts;
-    int num_accounts;
+    account_store *store;
+    account_index *index;
     FILE *input;
+    mapped_input *mapped;          // NULL unless the input was mmapped with -m
     pthread_mutex_t *file_mutex;
-    pthread_mutex_t *account_mutexes;
-    int *global_transaction_count;
+    txn_counter *counter;
     pthread_mutex_t *global_mutex;
     pthread_cond_t *update_cond;
     pthread_barrier_t *start_barrier;
     int *active_threads;
+    int batched;                   // -B: deposits and withdrawals are merged in per-worker batches
+    int stop_the_world;            // -S: park every worker while the bank applies rewards
+    account_history *history;      // -H: balance history files written after every reward, else NULL
+    int id;                        // the worker's slot in worker_epochs
+    int cpu;                       // -p: the CPU the thread pins itself to, else -1
 } WorkerArgs;
 
+// The reward epoch a worker's current transaction belongs to, on its own cache
+// line. EPOCH_IDLE once the worker has exited.
+typedef struct {
+    atomic_uint epoch;
+} __attribute__((aligned(CACHE_LINE))) worker_epoch;
+
+#define EPOCH_IDLE UINT32_MAX
+
+// Where the time of the threshold reward cycles went, reported with -T
+typedef struct {
+    int cycles;
+    long long quiesce_ns;          // bank waiting for workers to leave the epoch (or to park with -S)
+    long long sweep_ns;            // bank applying rewards to every account
+    atomic_llong counter_wait_ns;  // workers waiting for bank_mutex to hand a crossed threshold over
+    atomic_int counter_handoffs;
+    atomic_llong worker_stall_ns;  // workers parked, or blocked on an account the bank held
+    long long history_wait_ns;     // bank waiting for the history writer to hand a snapshot buffer back
+} reward_stats;
+
 pthread_mutex_t bank_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t bank_cond = PTHREAD_COND_INITIALIZER;
+pthread_cond_t resume_cond = PTHREAD_COND_INITIALIZER;
 pthread_barrier_t start_barrier;
-int global_transaction_count = 0;
+txn_counter global_transaction_count;
+counter_shard *counter_shards;    // one per worker
 int active_threads = 0;
+int pending_cycles = 0;            // thresholds crossed that the bank has not rewarded yet
+int paused_workers = 0;
+atomic_int pause_requested;
+atomic_int reward_running;
+atomic_uint reward_epoch;
+worker_epoch *worker_epochs;      // one per worker
+money_t *rewarded_tracter;         // per account, everything paid out so far, owned by the bank thread
+reward_stats stats;
+int num_workers;                   // -w, as many as the CPUs the bank may run on by default
 
+int next_line(WorkerArgs *args, input_cursor *cursor, char *buffer, int size);
+void lock_account(account_state *state);
+void apply_transaction(WorkerArgs *args, delta_batch *batch, const transaction *txn, int slot);
+void wait_for_reward_cycle(void);
+void threshold_reached(WorkerArgs *args, delta_batch *batch, int slot, int crossed);
 void* process_transactions_thread(void *arg);
+void apply_rewards(account_store *store, money_t *rewarded, int slot, money_t *snapshot);
+void reward_cycle(WorkerArgs *args);
 void* bank_thread(void *arg);
+void write_output(account_store *store);
+void print_reward_stats(int stop_the_world, int history);
+long long now_ns(void);
 
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <input_file>\n", argv[0]);
+    int use_mmap = 0;
+    int batched = 0;
+    int stop_the_world = 0;
+    int report = 0;
+    const char *history_dir = NULL;
+    int pin = 0;
+    int print_phases = 0;
+    int opt;
+    phase_timer phases;
+
+    phase_timer_start(&phases);
+    while ((opt = getopt(argc, argv, "mBSTH:Pw:p")) != -1) {
+        switch (opt) {
+        case 'm': // workers read chunks of the mmapped file instead of sharing fgets
+            use_mmap = 1;
+            break;
+        case 'B': // fold deposits and withdrawals into per-worker deltas, merged in batches
+            batched = 1;
+            break;
+        case 'S': // the old reward cycle: every worker waits while the bank applies rewards
+            stop_the_world = 1;
+            break;
+        case 'T': // print reward cycle timings and worker stall time to stderr
+            report = 1;
+            break;
+        case 'H': // append every account's balance after each reward cycle to <dir>/act_N.txt
+            history_dir = optarg;
+            break;
+        case 'P': // print per-phase times and peak RSS to stderr, for bench_suite.sh
+            print_phases = 1;
+            break;
+        case 'w': // number of worker threads
+            num_workers = atoi(optarg);
+            if (num_workers < 1) {
+                fprintf(stderr, "-w needs a positive number of workers\n");
+                return 1;
+            }
+            break;
+        case 'p': // pin the workers and the bank thread to distinct cores, filling one NUMA node first
+            pin = 1;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-m] [-B] [-S] [-T] [-H history_dir] [-w workers] [-p] [-P] <input_file>\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "Usage: %s [-m] [-B] [-S] [-T] [-H history_dir] [-w workers] [-p] [-P] <input_file>\n", argv[0]);
+        return 1;
+    }
+    const char *input_path = argv[optind];
+    if (num_workers == 0) {
+        num_workers = cpu_count();
+        if (pin && num_workers > 1) {
+            num_workers--; // -p keeps a core free for the bank thread
+        }
+    }
+    cpu_topology topology = {NULL, 0};
+    if (pin && cpu_topology_load(&topology) != 0) {
+        perror("Error reading the CPU topology");
         return 1;
     }
 
-    FILE *input = fopen(argv[1], "r");
+    FILE *input = fopen(input_path, "r");
     if (!input) {
         perror("Error opening file");
         return 1;
     }
 
-    int num_accounts;
-    fscanf(input, "%d\n", &num_accounts);
+    account_header header;
+    if (account_header_open(&header, input_path) != 0) {
+        fprintf(stderr, "Error reading account header of %s\n", input_path);
+        return 1;
+    }
+    int num_accounts = header.num_accounts;
+
+    account_store store;
+    if (account_store_init(&store, num_accounts) != 0) {
+        perror("Account store allocation failed");
+        return 1;
+    }
+
+    Account *accounts = store.accounts;
+    if (account_header_parse(&header, accounts, &store.state[0].balance, sizeof(account_state), num_workers) != 0) {
+        fprintf(stderr, "Malformed account header in %s\n", input_path);
+        return 1;
+    }
+    size_t body = header.body;
+    account_header_close(&header);
+    fseek(input, body, SEEK_SET); // workers read the transactions with fgets from here
+
+    account_history history;
+    if (history_dir != NULL && account_history_start(&history, accounts, num_accounts, history_dir) != 0) {
+        perror("Error starting the balance history");
+        return 1;
+    }
+
+    account_index index;
+    if (account_index_build(&index, accounts, num_accounts) != 0) {
+        perror("Account index allocation failed");
+        return 1;
+    }
 
-    account *accounts = malloc(sizeof(account) * num_accounts);
-    pthread_mutex_t *account_mutexes = malloc(sizeof(pthread_mutex_t) * num_accounts);
-    for (int i = 0; i < num_accounts; i++) {
-        fscanf(input, "index %*d\n");
-        fscanf(input, "%s\n", accounts[i].account_number);
-        fscanf(input, "%s\n", accounts[i].password);
-        fscanf(input, "%lf\n", &accounts[i].balance);
-        fscanf(input, "%lf\n", &accounts[i].reward_rate);
-        accounts[i].transaction_tracter = 0.0;
-        pthread_mutex_init(&account_mutexes[i], NULL);
+    mapped_input mapped;
+    if (use_mmap && mapped_input_open(&mapped, input_path, body) != 0) {
+        perror("Error mapping input file");
+        return 1;
     }
 
     pthread_mutex_t file_mutex;
     pthread_mutex_init(&file_mutex, NULL);
 
-    pthread_barrier_init(&start_barrier, NULL, NUM_WORKERS + 1);
+    pthread_barrier_init(&start_barrier, NULL, num_workers + 1);
 
-    pthread_t workers[NUM_WORKERS], bank;
+    pthread_t *workers = malloc(sizeof(pthread_t) * num_workers), bank;
+    WorkerArgs *worker_args = malloc(sizeof(WorkerArgs) * num_workers);
+    counter_shards = aligned_alloc(CACHE_LINE, sizeof(counter_shard) * num_workers);
+    worker_epochs = aligned_alloc(CACHE_LINE, sizeof(worker_epoch) * num_workers);
+    if (workers == NULL || worker_args == NULL || counter_shards == NULL || worker_epochs == NULL) {
+        perror("Worker allocation failed");
+        return 1;
+    }
+    memset(counter_shards, 0, sizeof(counter_shard) * num_workers);
+    memset(worker_epochs, 0, sizeof(worker_epoch) * num_workers);
     WorkerArgs args = {
-        accounts,
-        num_accounts,
+        &store,
+        &index,
         input,
+        use_mmap ? &mapped : NULL,
         &file_mutex,
-        account_mutexes,
         &global_transaction_count,
         &bank_mutex,
         &bank_cond,
         &start_barrier,
-        &active_threads
+        &active_threads,
+        batched,
+        stop_the_world,
+        history_dir != NULL ? &history : NULL,
+        -1,
+        pin ? cpu_topology_cpu(&topology, 0) : -1 // slot 0 is the bank thread's, the workers take the slots after it
     };
 
+    rewarded_tracter = calloc(num_accounts > 0 ? num_accounts : 1, sizeof(money_t));
+    if (rewarded_tracter == NULL) {
+        perror("Reward tracter allocation failed");
+        return 1;
+    }
+
+    txn_counter_init(&global_transaction_count, TRANSACTION_THRESHOLD);
+    active_threads = num_workers;
     pthread_create(&bank, NULL, bank_thread, &args);
 
-    for (int i = 0; i < NUM_WORKERS; i++) {
-        pthread_create(&workers[i], NULL, process_transactions_thread, &args);
+    for (int i = 0; i < num_workers; i++) {
+        worker_args[i] = args;
+        worker_args[i].id = i;
+        worker_args[i].cpu = pin ? cpu_topology_cpu(&topology, i + 1) : -1;
+        pthread_create(&workers[i], NULL, process_transactions_thread, &worker_args[i]);
     }
 
+    phase_timer_mark(&phases, PHASE_HEADER);
     pthread_barrier_wait(&start_barrier); // Signal all threads to start processing
 
-    for (int i = 0; i < NUM_WORKERS; i++) {
+    for (int i = 0; i < num_workers; i++) {
         pthread_join(workers[i], NULL);
     }
 
@@ -96,54 +263,206 @@ int main(int argc, char *argv[]) {
     pthread_mutex_unlock(&bank_mutex);
 
     pthread_join(bank, NULL);
+    phase_timer_mark(&phases, PHASE_PROCESS);
+    phase_timer_add(&phases, PHASE_REWARDS, stats.sweep_ns); // the sweeps ran during processing
 
+    write_output(&store);
+    phase_timer_mark(&phases, PHASE_OUTPUT);
+    if (history_dir != NULL && account_history_finish(&history) != 0) {
+        fprintf(stderr, "Error writing the balance history to %s\n", history_dir);
+    }
+    if (report) {
+        print_reward_stats(stop_the_world, history_dir != NULL);
+    }
+    if (print_phases) {
+        phase_timer_report(&phases, stderr);
+    }
+
+    if (use_mmap) {
+        mapped_input_close(&mapped);
+    }
     fclose(input);
     pthread_barrier_destroy(&start_barrier);
     pthread_mutex_destroy(&file_mutex);
-    for (int i = 0; i < num_accounts; i++) {
-        pthread_mutex_destroy(&account_mutexes[i]);
-    }
-    free(account_mutexes);
-    free(accounts);
+    free(rewarded_tracter);
+    account_index_free(&index);
+    account_store_free(&store);
+    free(workers);
+    free(worker_args);
+    free(counter_shards);
+    free(worker_epochs);
+    cpu_topology_free(&topology);
     return 0;
 }
 
+// Reads the next transaction line into buffer, returns 0 at the end of the input.
+// In mmap mode the worker walks its own chunk and takes no lock per line.
+int next_line(WorkerArgs *args, input_cursor *cursor, char *buffer, int size) {
+    if (args->mapped != NULL) {
+        return mapped_input_next_line(args->mapped, cursor, buffer, size);
+    }
+
+    pthread_mutex_lock(args->file_mutex);
+    char *line = fgets(buffer, size, args->input);
+    pthread_mutex_unlock(args->file_mutex);
+    return line != NULL;
+}
+
+// Takes an account lock, timing the wait when the bank thread is the one that
+// might be holding it during a reward sweep.
+void lock_account(account_state *state) {
+    if (pthread_mutex_trylock(&state->lock) == 0) {
+        return;
+    }
+    if (!atomic_load_explicit(&reward_running, memory_order_relaxed)) {
+        pthread_mutex_lock(&state->lock);
+        return;
+    }
+
+    long long start = now_ns();
+    pthread_mutex_lock(&state->lock);
+    atomic_fetch_add_explicit(&stats.worker_stall_ns, now_ns() - start, memory_order_relaxed);
+}
+
+// Applies one resolved transaction under the per-account locks, adding to the
+// tracter slot of the worker's current reward epoch. With a batch, deposits and
+// withdrawals only land in the worker's pending deltas until the batch is merged.
+void apply_transaction(WorkerArgs *args, delta_batch *batch, const transaction *txn, int slot) {
+    account_state *src;
+
+    if (txn->src < 0 || !txn->authorized) {
+        return;
+    }
+    src = &args->store->state[txn->src];
+
+    if (batch != NULL && (txn->type == 'D' || txn->type == 'W')) {
+        money_t change = txn->type == 'D' ? txn->amount : -txn->amount;
+        if (delta_batch_add(batch, txn->src, change, txn->amount)) {
+            delta_batch_merge(batch, args->store, slot);
+        }
+        return;
+    }
+
+    if (txn->type == 'D') { // Deposit
+        lock_account(src);
+        src->balance += txn->amount;
+        src->transaction_tracter[slot] += txn->amount;
+        pthread_mutex_unlock(&src->lock);
+    } else if (txn->type == 'W') { // Withdraw
+        lock_account(src);
+        src->balance -= txn->amount;
+        src->transaction_tracter[slot] += txn->amount;
+        pthread_mutex_unlock(&src->lock);
+    } else if (txn->type == 'T') { // Transfer
+        lock_account(src);
+        src->balance -= txn->amount;
+        src->transaction_tracter[slot] += txn->amount;
+        pthread_mutex_unlock(&src->lock);
+
+        if (txn->dest >= 0) {
+            account_state *dest = &args->store->state[txn->dest];
+            lock_account(dest);
+            dest->balance += txn->amount;
+            pthread_mutex_unlock(&dest->lock);
+        }
+    }
+    // Check Balance only reads, nothing to apply
+}
+
+// Stop-the-world mode only: parks the worker until the bank has finished the
+// reward cycle, counting the time as stall.
+void wait_for_reward_cycle(void) {
+    long long start = now_ns();
+
+    pthread_mutex_lock(&bank_mutex);
+    paused_workers++;
+    pthread_cond_signal(&bank_cond);
+    while (atomic_load(&pause_requested)) {
+        pthread_cond_wait(&resume_cond, &bank_mutex);
+    }
+    paused_workers--;
+    pthread_mutex_unlock(&bank_mutex);
+
+    atomic_fetch_add_explicit(&stats.worker_stall_ns, now_ns() - start, memory_order_relaxed);
+}
+
+// Hands thresholds crossed by this worker's counter flush to the bank thread,
+// the only time a worker takes bank_mutex outside stop-the-world pauses.
+void threshold_reached(WorkerArgs *args, delta_batch *batch, int slot, int crossed) {
+    if (batch != NULL) { // the reward has to see everything this worker applied
+        delta_batch_merge(batch, args->store, slot);
+    }
+
+    long long start = now_ns();
+    pthread_mutex_lock(args->global_mutex);
+    atomic_fetch_add_explicit(&stats.counter_wait_ns, now_ns() - start, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats.counter_handoffs, 1, memory_order_relaxed);
+
+    pending_cycles += crossed;
+    if (args->stop_the_world) {
+        atomic_store(&pause_requested, 1);
+    }
+    pthread_cond_signal(args->update_cond);
+    pthread_mutex_unlock(args->global_mutex);
+}
+
 void* process_transactions_thread(void *arg) {
     WorkerArgs *args = (WorkerArgs *)arg;
+    atomic_uint *announced = &worker_epochs[args->id].epoch;
+    input_cursor cursor = {NULL, NULL};
     char buffer[256];
-    int local_transaction_count = 0;
+    counter_shard *shard = &counter_shards[args->id];
+    delta_batch *batch = NULL;
+
+    // pinned before allocating, so the worker's buffers come from its own node
+    if (args->cpu >= 0) {
+        cpu_pin_thread(args->cpu);
+    }
+    if (args->batched) {
+        batch = malloc(sizeof(delta_batch));
+        if (batch == NULL) {
+            perror("Delta batch allocation failed");
+            exit(1);
+        }
+        delta_batch_init(batch);
+    }
 
     pthread_barrier_wait(args->start_barrier);
 
-    while (1) {
-        pthread_mutex_lock(args->file_mutex);
-        if (!fgets(buffer, sizeof(buffer), args->input)) {
-            pthread_mutex_unlock(args->file_mutex);
-            break;
-        }
-        pthread_mutex_unlock(args->file_mutex);
+    while (next_line(args, &cursor, buffer, sizeof(buffer))) {
 
-        command_line cmd = str_filler(buffer, " ");
-        if (cmd.num_token == 0) {
-            free_command_line(&cmd);
+        transaction txn;
+        if (!transaction_parse(buffer, args->index, &txn)) {
             continue;
         }
+        if (args->stop_the_world && atomic_load_explicit(&pause_requested, memory_order_acquire)) {
+            wait_for_reward_cycle();
+        }
 
-        char *type = cmd.command_list[0];
-        if (strcmp(type, "C") != 0) { // Exclude Check Balance
-            local_transaction_count++;
-            pthread_mutex_lock(args->global_mutex);
-            *(args->global_transaction_count) += 1;
-            if (*(args->global_transaction_count) >= TRANSACTION_THRESHOLD) {
-                pthread_cond_signal(args->update_cond);
-                pthread_cond_wait(&bank_cond, args->global_mutex);
+        // Announcing the epoch before touching any tracter is what lets the bank
+        // thread tell when nobody can still be writing to the previous slot.
+        unsigned int epoch = atomic_load_explicit(&reward_epoch, memory_order_acquire);
+        atomic_store_explicit(announced, epoch, memory_order_release);
+        apply_transaction(args, batch, &txn, epoch & 1);
+
+        if (txn.type != 'C') { // Exclude Check Balance
+            int crossed = txn_counter_add(args->counter, shard);
+            if (crossed > 0) {
+                threshold_reached(args, batch, epoch & 1, crossed);
             }
-            pthread_mutex_unlock(args->global_mutex);
         }
-        // Handle transactions here...
-        free_command_line(&cmd);
     }
 
+    int crossed = txn_counter_flush(args->counter, shard);
+    if (crossed > 0) {
+        threshold_reached(args, batch, atomic_load(&reward_epoch) & 1, crossed);
+    }
+    if (batch != NULL) {
+        delta_batch_merge(batch, args->store, atomic_load(&reward_epoch) & 1);
+        free(batch);
+    }
+    atomic_store_explicit(announced, EPOCH_IDLE, memory_order_release);
+
     pthread_mutex_lock(&bank_mutex);
     *(args->active_threads) -= 1;
     pthread_cond_signal(&bank_cond);
@@ -152,18 +471,142 @@ void* process_transactions_thread(void *arg) {
     pthread_exit(NULL);
 }
 
+// Pays every account its reward on the tracter in the given epoch slot and
+// clears the slot. Each account is locked on its own so workers are only held
+// up when they hit the account being rewarded. The payment is the growth of the
+// reward on the account's whole rewarded tracter, so the cycles add up to the
+// one reward a single final update would pay instead of rounding every cycle.
+// With a snapshot buffer the rewarded balance is recorded there for the history.
+void apply_rewards(account_store *store, money_t *rewarded, int slot, money_t *snapshot) {
+    for (int i = 0; i < store->num_accounts; i++) {
+        account_state *state = &store->state[i];
+        rate_t rate = store->accounts[i].reward_rate;
+        money_t before = money_reward(rewarded[i], rate);
+
+        pthread_mutex_lock(&state->lock);
+        rewarded[i] += state->transaction_tracter[slot];
+        state->balance += money_reward(rewarded[i], rate) - before;
+        state->transaction_tracter[slot] = 0;
+        if (snapshot != NULL) {
+            snapshot[i] = state->balance;
+        }
+        pthread_mutex_unlock(&state->lock);
+    }
+}
+
+// One threshold reward cycle. The epoch is advanced first so new transactions go
+// to the other tracter slot, then the bank waits until every worker has moved
+// past the closing epoch and rewards its slot while the workers keep going.
+// With -S the workers are already parked and nothing has to be waited for.
+// The history snapshot buffer is taken before the epoch moves, so a writer
+// lagging behind only delays the bank, never a worker.
+void reward_cycle(WorkerArgs *args) {
+    money_t *snapshot = NULL;
+
+    if (args->history != NULL) {
+        long long wait = now_ns();
+        snapshot = account_history_acquire(args->history);
+        stats.history_wait_ns += now_ns() - wait;
+    }
+
+    unsigned int closing = atomic_load(&reward_epoch);
+    long long start = now_ns();
+
+    atomic_store(&reward_epoch, closing + 1);
+    if (!args->stop_the_world) {
+        for (int i = 0; i < num_workers; i++) {
+            while (atomic_load_explicit(&worker_epochs[i].epoch, memory_order_acquire) <= closing) {
+                sched_yield();
+            }
+        }
+    }
+    long long swept = now_ns();
+
+    atomic_store_explicit(&reward_running, 1, memory_order_relaxed);
+    apply_rewards(args->store, rewarded_tracter, closing & 1, snapshot);
+    atomic_store_explicit(&reward_running, 0, memory_order_relaxed);
+    if (snapshot != NULL) {
+        account_history_submit(args->history, snapshot);
+    }
+
+    stats.cycles++;
+    stats.quiesce_ns += swept - start;
+    stats.sweep_ns += now_ns() - swept;
+}
+
 void* bank_thread(void *arg) {
     WorkerArgs *args = (WorkerArgs *)arg;
+    int updates = 0;
+
+    if (args->cpu >= 0) {
+        cpu_pin_thread(args->cpu);
+    }
 
     pthread_mutex_lock(&bank_mutex);
-    while (*(args->active_threads) > 0) {
-        pthread_cond_wait(&bank_cond, &bank_mutex);
-        if (*(args->global_transaction_count) >= TRANSACTION_THRESHOLD || *(args->active_threads) == 0) {
-            // Apply rewards logic
-            *(args->global_transaction_count) = 0; // Reset counter
-            pthread_cond_broadcast(args->update_cond); // Resume worker threads
+    while (1) {
+        while (pending_cycles == 0 && *(args->active_threads) > 0) {
+            pthread_cond_wait(&bank_cond, &bank_mutex);
+        }
+        if (pending_cycles == 0) {
+            break; // every worker is done
+        }
+        pending_cycles--;
+
+        long long start = now_ns();
+        while (args->stop_the_world && paused_workers < *(args->active_threads)) {
+            pthread_cond_wait(&bank_cond, &bank_mutex);
+        }
+        stats.quiesce_ns += now_ns() - start;
+        pthread_mutex_unlock(&bank_mutex);
+
+        reward_cycle(args);
+        updates++;
+
+        pthread_mutex_lock(&bank_mutex);
+        if (pending_cycles == 0) {
+            atomic_store(&pause_requested, 0);
+            pthread_cond_broadcast(&resume_cond); // Resume worker threads
         }
     }
     pthread_mutex_unlock(&bank_mutex);
-    pthread_exit(NULL);
+
+    // Final update, no worker is left so both slots can be paid out
+    money_t *snapshot = args->history != NULL ? account_history_acquire(args->history) : NULL;
+    apply_rewards(args->store, rewarded_tracter, 0, NULL);
+    apply_rewards(args->store, rewarded_tracter, 1, snapshot);
+    if (snapshot != NULL) {
+        account_history_submit(args->history, snapshot);
+    }
+    updates++;
+
+    pthread_exit((void *)(intptr_t)updates);
+}
+
+void write_output(account_store *store) {
+    if (output_write("out.txt", &store->state[0].balance, sizeof(account_state), store->num_accounts,
+                     num_workers) != 0) {
+        perror("Error writing out.txt");
+    }
+}
+
+void print_reward_stats(int stop_the_world, int history) {
+    int cycles = stats.cycles > 0 ? stats.cycles : 1;
+
+    fprintf(stderr, "Reward cycles: %d (%s)\n", stats.cycles, stop_the_world ? "stop-the-world" : "epoch");
+    fprintf(stderr, "Bank wait per cycle: %.1f us (%s)\n", stats.quiesce_ns / 1e3 / cycles,
+            stop_the_world ? "workers parking" : "workers leaving the closing epoch");
+    fprintf(stderr, "Reward sweep per cycle: %.1f us\n", stats.sweep_ns / 1e3 / cycles);
+    fprintf(stderr, "Worker stall per cycle: %.1f us summed over %d workers\n",
+            atomic_load(&stats.worker_stall_ns) / 1e3 / cycles, num_workers);
+    fprintf(stderr, "Counter lock wait: %.1f us over %d threshold handoffs\n",
+            atomic_load(&stats.counter_wait_ns) / 1e3, atomic_load(&stats.counter_handoffs));
+    if (history) {
+        fprintf(stderr, "History buffer wait per cycle: %.1f us\n", stats.history_wait_ns / 1e3 / cycles);
+    }
+}
+
+long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
 }
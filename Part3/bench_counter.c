@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include "txn_counter.h"
+
+#define NUM_THREADS 10
+#define TRANSACTIONS_PER_THREAD 1000000
+#define TRANSACTION_THRESHOLD 5000
+
+// Counts the same fixed number of transactions from 10 threads the way Part3
+// used to (every transaction takes one mutex to bump and test the global
+// count) and through per-worker txn_counter shards, where the mutex is only
+// taken to hand a crossed threshold over. Reports the wall time and the total
+// time threads spent waiting for the mutex.
+
+typedef struct {
+    int sharded;
+    counter_shard *shard;
+} BenchArgs;
+
+pthread_mutex_t count_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t count_cond = PTHREAD_COND_INITIALIZER;
+int global_count = 0;
+txn_counter counter;
+atomic_llong lock_wait_ns;
+atomic_int thresholds;
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// takes count_mutex, timing only the waits that did not get it straight away
+static void lock_counted(void)
+{
+    if (pthread_mutex_trylock(&count_mutex) == 0) {
+        return;
+    }
+    long long start = now_ns();
+    pthread_mutex_lock(&count_mutex);
+    atomic_fetch_add(&lock_wait_ns, now_ns() - start);
+}
+
+static void hand_over(int crossed)
+{
+    lock_counted();
+    atomic_fetch_add(&thresholds, crossed);
+    pthread_cond_signal(&count_cond);
+    pthread_mutex_unlock(&count_mutex);
+}
+
+static void* count_transactions(void *arg)
+{
+    BenchArgs *args = (BenchArgs *)arg;
+
+    for (int n = 0; n < TRANSACTIONS_PER_THREAD; n++) {
+        if (args->sharded) {
+            int crossed = txn_counter_add(&counter, args->shard);
+            if (crossed > 0) {
+                hand_over(crossed);
+            }
+        } else {
+            lock_counted();
+            if (++global_count >= TRANSACTION_THRESHOLD) {
+                global_count = 0;
+                atomic_fetch_add(&thresholds, 1);
+                pthread_cond_signal(&count_cond);
+            }
+            pthread_mutex_unlock(&count_mutex);
+        }
+    }
+    if (args->sharded) {
+        int crossed = txn_counter_flush(&counter, args->shard);
+        if (crossed > 0) {
+            hand_over(crossed);
+        }
+    }
+    return NULL;
+}
+
+static void run(const char *name, int sharded)
+{
+    pthread_t threads[NUM_THREADS];
+    BenchArgs args[NUM_THREADS];
+    counter_shard *shards = aligned_alloc(CACHE_LINE, sizeof(counter_shard) * NUM_THREADS);
+
+    if (shards == NULL) {
+        perror("Allocation failed");
+        exit(1);
+    }
+    global_count = 0;
+    txn_counter_init(&counter, TRANSACTION_THRESHOLD);
+    atomic_store(&lock_wait_ns, 0);
+    atomic_store(&thresholds, 0);
+
+    long long start = now_ns();
+    for (int t = 0; t < NUM_THREADS; t++) {
+        shards[t].unflushed = 0;
+        args[t] = (BenchArgs){sharded, &shards[t]};
+        pthread_create(&threads[t], NULL, count_transactions, &args[t]);
+    }
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    long long elapsed = now_ns() - start;
+
+    printf("%s\t%.1f\t\t%.1f\t\t%d\n", name, elapsed / 1e6, atomic_load(&lock_wait_ns) / 1e6,
+           atomic_load(&thresholds));
+    free(shards);
+}
+
+int main(void)
+{
+    printf("%d threads x %d transactions, threshold %d\n", NUM_THREADS, TRANSACTIONS_PER_THREAD,
+           TRANSACTION_THRESHOLD);
+    printf("counter\twall ms\t\tlock wait ms\tthresholds\n");
+    run("mutex", 0);
+    run("sharded", 1);
+    return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef INPUT_READER_H_
+#define INPUT_READER_H_
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#ifndef INPUT_CHUNK_SIZE
+#define INPUT_CHUNK_SIZE (1 << 20)
+#endif
+
+//the transaction file mapped into memory, the part after the account header is
+//cut into INPUT_CHUNK_SIZE pieces that workers claim one at a time
+typedef struct
+{
+    const char* data;
+    size_t size;
+    size_t body;                    // offset of the first transaction line
+    size_t num_chunks;
+    atomic_size_t next_chunk;       // next chunk nobody has claimed yet
+}mapped_input;
+
+//the lines of the chunk a worker is currently reading, owned by that worker
+typedef struct
+{
+    const char* pos;
+    const char* end;
+}input_cursor;
+
+//maps path read-only, body is the offset where the transaction lines start
+//(ftell after the header was parsed), returns 0 on success
+int mapped_input_open(mapped_input* input, const char* path, size_t body);
+
+//copies the next line of the cursor's chunk into buffer as a NUL terminated
+//string, claiming a new chunk when the current one is used up. Only the chunk
+//claim touches shared state. Returns 0 once every chunk has been handed out.
+int mapped_input_next_line(mapped_input* input, input_cursor* cursor, char* buffer, size_t size);
+
+void mapped_input_close(mapped_input* input);
+
+#endif /* INPUT_READER_H_ */
@@ -0,0 +1,18 @@
+#ifndef OUTPUT_WRITER_H_
+#define OUTPUT_WRITER_H_
+
+#include <stddef.h>
+#include "money.h"
+
+#define OUTPUT_MIN_ACCOUNTS_PER_THREAD 16384   // below this a thread costs more than it formats
+
+//writes the "N balance:\t<balance>\n\n" lines of every account to path, the
+//same bytes as one fprintf(MONEY_FMT) per account. Balances are read from
+//balance with balance_stride bytes between accounts, like account_header_parse
+//stores them. Ranges of accounts are formatted by up to num_threads threads
+//and the file is written in one pass over the formatted text.
+//Returns 0 on success, -1 with errno set if the file cannot be written.
+int output_write(const char* path, const money_t* balance, size_t balance_stride,
+                 int num_accounts, int num_threads);
+
+#endif /* OUTPUT_WRITER_H_ */
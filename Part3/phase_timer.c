@@ -0,0 +1,44 @@
+#include <time.h>
+#include <sys/resource.h>
+#include "phase_timer.h"
+
+static const char* phase_names[NUM_PHASES] = {"header", "process", "rewards", "output"};
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void phase_timer_start(phase_timer* timer)
+{
+    for (int p = 0; p < NUM_PHASES; p++) {
+        timer->ns[p] = 0;
+    }
+    timer->mark_ns = monotonic_ns();
+}
+
+void phase_timer_mark(phase_timer* timer, phase p)
+{
+    int64_t now = monotonic_ns();
+    timer->ns[p] += now - timer->mark_ns;
+    timer->mark_ns = now;
+}
+
+void phase_timer_add(phase_timer* timer, phase p, int64_t ns)
+{
+    timer->ns[p] += ns;
+}
+
+void phase_timer_report(const phase_timer* timer, FILE* out)
+{
+    struct rusage usage;
+    long peak_rss_kb = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : -1; // kilobytes on Linux
+
+    fprintf(out, "phases");
+    for (int p = 0; p < NUM_PHASES; p++) {
+        fprintf(out, " %s_ms=%.3f", phase_names[p], timer->ns[p] / 1e6);
+    }
+    fprintf(out, " peak_rss_kb=%ld\n", peak_rss_kb);
+}
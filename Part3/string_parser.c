@@ -106,6 +106,45 @@ command_line str_filler(char* buf, const char* delim)
 
 
 
+int str_tokenize(char* buf, const char* delim, token_view* view)
+{
+    char* p = buf;
+
+    view->num_token = 0;
+    if (buf == NULL) {
+        return 0;
+    }
+
+    while (view->num_token < MAX_TOKENS) {
+        // Skip leading delimeters
+        while (*p != '\0' && strchr(delim, *p) != NULL) {
+            p++;
+        }
+        if (*p == '\0' || *p == '\n' || *p == '\r') {
+            break;
+        }
+
+        view->tokens[view->num_token++] = p;
+
+        // Walk to the end of the token and terminate it in place
+        while (*p != '\0' && *p != '\n' && *p != '\r' && strchr(delim, *p) == NULL) {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if (*p == '\n' || *p == '\r') {
+            *p = '\0';
+            break;
+        }
+        *p++ = '\0';
+    }
+
+    return view->num_token;
+}
+
+
+
 void free_command_line(command_line* command)
 {
     if (command == NULL) return;
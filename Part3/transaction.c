@@ -0,0 +1,40 @@
+#include <stdlib.h>
+#include <string.h>
+#include "transaction.h"
+#include "string_parser.h"
+
+int transaction_parse(char* line, const account_index* index, transaction* txn)
+{
+    token_view cmd;
+    if (str_tokenize(line, " ", &cmd) == 0 || cmd.tokens[0][1] != '\0') {
+        return 0;
+    }
+
+    txn->type = cmd.tokens[0][0];
+    txn->dest = -1;
+    txn->amount = 0;
+
+    switch (txn->type) {
+    case 'D': // Deposit
+    case 'W': // Withdraw
+        if (cmd.num_token < 4) return 0;
+        txn->amount = money_parse(cmd.tokens[3]);
+        break;
+    case 'T': // Transfer
+        if (cmd.num_token < 5) return 0;
+        txn->dest = account_index_find(index, cmd.tokens[3]);
+        txn->amount = money_parse(cmd.tokens[4]);
+        break;
+    case 'C': // Check Balance
+        if (cmd.num_token < 2) return 0;
+        break;
+    default:
+        return 0;
+    }
+
+    txn->src = account_index_find(index, cmd.tokens[1]);
+    txn->authorized = txn->src >= 0 && cmd.num_token > 2 &&
+                      strcmp(index->accounts[txn->src].password, cmd.tokens[2]) == 0;
+    return 1;
+}
+
@@ -0,0 +1,30 @@
+#include "txn_counter.h"
+
+void txn_counter_init(txn_counter* counter, long threshold)
+{
+    atomic_init(&counter->total, 0);
+    counter->threshold = threshold;
+}
+
+int txn_counter_add(txn_counter* counter, counter_shard* shard)
+{
+    if (++shard->unflushed < COUNTER_FLUSH) {
+        return 0;
+    }
+    return txn_counter_flush(counter, shard);
+}
+
+int txn_counter_flush(txn_counter* counter, counter_shard* shard)
+{
+    long added = shard->unflushed;
+
+    if (added == 0) {
+        return 0;
+    }
+    shard->unflushed = 0;
+
+    // the total never resets, a threshold is crossed whenever the flush moves
+    // it into the next multiple
+    long before = atomic_fetch_add_explicit(&counter->total, added, memory_order_relaxed);
+    return (int)((before + added) / counter->threshold - before / counter->threshold);
+}
@@ -0,0 +1,36 @@
+#ifndef TXN_COUNTER_H_
+#define TXN_COUNTER_H_
+
+#include <stdatomic.h>
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#define COUNTER_FLUSH 64    // transactions a worker counts locally before adding them to the total
+
+//the running count of non-check transactions, only written when a shard is flushed
+typedef struct
+{
+    atomic_long total;
+    long threshold;
+}txn_counter;
+
+//a worker's unflushed count, on a cache line of its own so counting a
+//transaction never touches a line another worker writes
+typedef struct
+{
+    int unflushed;
+} __attribute__((aligned(CACHE_LINE))) counter_shard;
+
+void txn_counter_init(txn_counter* counter, long threshold);
+
+//counts one transaction on the shard and flushes it every COUNTER_FLUSH
+//transactions, returns the number of thresholds the flush crossed
+int txn_counter_add(txn_counter* counter, counter_shard* shard);
+
+//adds whatever the shard still holds to the total, returns the number of
+//thresholds crossed
+int txn_counter_flush(txn_counter* counter, counter_shard* shard);
+
+#endif /* TXN_COUNTER_H_ */
@@ -0,0 +1,346 @@
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "account_header.h"
+
+#define MAX_HEADER_THREADS 64
+
+#define BLOCK_TOKENS 6      // "index", N, account number, password, balance and rate
+
+typedef struct
+{
+    account_header* header;
+    Account* accounts;
+    money_t* balance;
+    size_t balance_stride;
+    size_t start;               // the thread parses the blocks whose "index" starts in [start, end)
+    size_t end;
+    size_t first;               // where its first block starts, the first block at or after start
+    size_t stop;                // where the block after its last one starts
+    size_t after;               // just past the rate of its last block
+    int parsed;
+    int failed;
+}header_range;
+
+static int is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Finds the next whitespace separated token at or after *pos, returns its
+// length (0 at the end of the data) and leaves *pos just past it
+static size_t next_token(const account_header* header, size_t* pos, const char** token)
+{
+    size_t p = *pos;
+
+    while (p < header->size && is_space(header->data[p])) {
+        p++;
+    }
+    *token = header->data + p;
+    size_t start = p;
+    while (p < header->size && !is_space(header->data[p])) {
+        p++;
+    }
+    *pos = p;
+    return p - start;
+}
+
+static int parse_int(const char* token, size_t length, long* value)
+{
+    if (length == 0 || length > 18) {
+        return -1;
+    }
+    *value = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (token[i] < '0' || token[i] > '9') {
+            return -1;
+        }
+        *value = *value * 10 + (token[i] - '0');
+    }
+    return 0;
+}
+
+// Block scanning works on local pointers, the compiler cannot keep header
+// fields in registers across the stores into the accounts
+
+static const char* skip_space(const char* p, const char* end)
+{
+    while (p < end && is_space(*p)) {
+        p++;
+    }
+    return p;
+}
+
+// Copies the token at p NUL terminated into out, returns the end of the token
+// or NULL if it is empty or does not fit
+static const char* copy_field(const char* p, const char* end, char* out, size_t out_size)
+{
+    size_t length = 0;
+
+    p = skip_space(p, end);
+    while (p < end && !is_space(*p)) {
+        if (length + 1 >= out_size) {
+            return NULL;
+        }
+        out[length++] = *p++;
+    }
+    out[length] = '\0';
+    return length > 0 ? p : NULL;
+}
+
+// The start of the token after the one at pos
+static size_t next_token_start(const account_header* header, size_t pos)
+{
+    while (pos < header->size && !is_space(header->data[pos])) {
+        pos++;
+    }
+    while (pos < header->size && is_space(header->data[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+// The first token starting at or after pos, a token pos falls inside of is skipped
+static size_t token_start(const account_header* header, size_t pos)
+{
+    if (pos > header->first_block && !is_space(header->data[pos - 1])) {
+        return next_token_start(header, pos);
+    }
+    while (pos < header->size && is_space(header->data[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+// Whether "index" followed by an integer token starts at pos
+static int starts_block(const account_header* header, size_t pos)
+{
+    const char* p = header->data + pos;
+    const char* end = header->data + header->size;
+
+    if (end - p < 7 || memcmp(p, "index", 5) != 0 || !is_space(p[5])) {
+        return 0;
+    }
+    p = skip_space(p + 5, end);
+    const char* digits = p;
+    while (p < end && *p >= '0' && *p <= '9') {
+        p++;
+    }
+    return p > digits && (p == end || is_space(*p));
+}
+
+// Whether a block starts within the BLOCK_TOKENS tokens from pos on. Blocks
+// are BLOCK_TOKENS tokens however they are spread over lines, so this holds
+// everywhere up to the last block's start and nowhere after it.
+static int block_ahead(const account_header* header, size_t pos)
+{
+    pos = token_start(header, pos);
+    for (int i = 0; i < BLOCK_TOKENS && pos < header->size; i++) {
+        if (starts_block(header, pos)) {
+            return 1;
+        }
+        pos = next_token_start(header, pos);
+    }
+    return 0;
+}
+
+static size_t next_line_start(const account_header* header, size_t pos)
+{
+    const char* newline = memchr(header->data + pos, '\n', header->size - pos);
+    return newline != NULL ? (size_t)(newline - header->data) + 1 : header->size;
+}
+
+// Parses the block whose index line starts at *pos, leaves *pos after its rate
+static int parse_block(header_range* range, size_t* pos)
+{
+    const char* data = range->header->data;
+    const char* end = data + range->header->size;
+    const char* p = data + *pos;
+    long index = 0;
+    char field[64];
+
+    p = skip_space(p, end);
+    if (end - p < 6 || memcmp(p, "index", 5) != 0 || !is_space(p[5])) {
+        return -1;
+    }
+    p = skip_space(p + 5, end);
+    const char* digits = p;
+    while (p < end && *p >= '0' && *p <= '9') {
+        index = index * 10 + (*p++ - '0');
+        if (index >= range->header->num_accounts) {
+            return -1;
+        }
+    }
+    if (p == digits || (p < end && !is_space(*p))) {
+        return -1;
+    }
+
+    Account* account = &range->accounts[index];
+    money_t* balance = (money_t*)((char*)range->balance + range->balance_stride * index);
+
+    if ((p = copy_field(p, end, account->account_number, sizeof(account->account_number))) == NULL ||
+        (p = copy_field(p, end, account->password, sizeof(account->password))) == NULL ||
+        (p = copy_field(p, end, field, sizeof(field))) == NULL) {
+        return -1;
+    }
+    *balance = money_parse(field);
+    if ((p = copy_field(p, end, field, sizeof(field))) == NULL) {
+        return -1;
+    }
+    account->reward_rate = rate_parse(field);
+
+    *pos = p - data;
+    return 0;
+}
+
+static void* parse_range(void* arg)
+{
+    header_range* range = (header_range*)arg;
+    account_header* header = range->header;
+    size_t pos = range->start;
+
+    // a range that does not start on a block boundary begins at the next block
+    if (pos != header->first_block) {
+        pos = token_start(header, pos);
+        while (pos < header->size && !starts_block(header, pos)) {
+            pos = next_token_start(header, pos);
+        }
+    }
+    range->first = pos;
+
+    while (pos < range->end && range->parsed < header->num_accounts) {
+        if (parse_block(range, &pos) != 0) {
+            range->failed = 1;
+            break;
+        }
+        range->parsed++;
+        range->after = pos;
+        while (pos < header->size && is_space(header->data[pos])) {
+            pos++;
+        }
+    }
+    range->stop = pos;
+    return NULL;
+}
+
+int account_header_open(account_header* header, const char* path)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps its own reference to the file
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    header->data = data;
+    header->size = st.st_size;
+
+    const char* token;
+    size_t pos = 0;
+    long num_accounts;
+    size_t length = next_token(header, &pos, &token);
+    if (parse_int(token, length, &num_accounts) != 0 || num_accounts > 0x7fffffff) {
+        account_header_close(header);
+        return -1;
+    }
+    while (pos < header->size && is_space(header->data[pos])) {
+        pos++;
+    }
+    header->num_accounts = num_accounts;
+    header->first_block = pos;
+    header->body = pos;
+    return 0;
+}
+
+int account_header_parse(account_header* header, Account* accounts, money_t* balance,
+                         size_t balance_stride, int num_threads)
+{
+    if (header->num_accounts == 0) {
+        return 0;
+    }
+
+    int max_threads = header->num_accounts / HEADER_MIN_BLOCKS_PER_THREAD;
+    if (num_threads > max_threads) num_threads = max_threads;
+    if (num_threads > MAX_HEADER_THREADS) num_threads = MAX_HEADER_THREADS;
+    if (num_threads < 1) num_threads = 1;
+
+    // binary search for the last block's start, every offset before it has
+    // another block within a block's worth of tokens
+    size_t low = header->first_block, high = header->size;
+    while (num_threads > 1 && low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (block_ahead(header, mid)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (num_threads > 1 && low > header->first_block) {
+        size_t last_block = low - 1;
+        header_range ranges[MAX_HEADER_THREADS];
+        pthread_t threads[MAX_HEADER_THREADS];
+        int started[MAX_HEADER_THREADS] = {0};
+        size_t span = last_block + 1 - header->first_block;
+
+        for (int t = 0; t < num_threads; t++) {
+            ranges[t] = (header_range){header, accounts, balance, balance_stride,
+                                       header->first_block + span * t / num_threads,
+                                       header->first_block + span * (t + 1) / num_threads, 0, 0, 0, 0, 0};
+        }
+        for (int t = 1; t < num_threads; t++) {
+            started[t] = pthread_create(&threads[t], NULL, parse_range, &ranges[t]) == 0;
+        }
+        parse_range(&ranges[0]);
+
+        int parsed = ranges[0].parsed, failed = ranges[0].failed;
+        for (int t = 1; t < num_threads; t++) {
+            if (started[t]) {
+                pthread_join(threads[t], NULL);
+            } else {
+                parse_range(&ranges[t]);
+            }
+            parsed += ranges[t].parsed;
+            failed |= ranges[t].failed;
+            // a range that resynchronized on a token only looking like a block
+            // start (a password "index") does not begin where the previous ended
+            failed |= ranges[t].first != ranges[t - 1].stop;
+        }
+
+        if (!failed && parsed == header->num_accounts) {
+            header->body = next_line_start(header, ranges[num_threads - 1].after);
+            return 0;
+        }
+    }
+
+    // one pass in file order needs no guess at where blocks start, it is the
+    // only pass for small headers and the fallback when the split went wrong
+    header_range whole = {header, accounts, balance, balance_stride, header->first_block, header->size,
+                          0, 0, 0, 0, 0};
+    parse_range(&whole);
+    if (whole.failed || whole.parsed != header->num_accounts) {
+        return -1;
+    }
+    header->body = next_line_start(header, whole.after);
+    return 0;
+}
+
+void account_header_close(account_header* header)
+{
+    if (header->data != NULL) {
+        munmap((void*)header->data, header->size);
+    }
+    header->data = NULL;
+    header->size = 0;
+}
@@ -0,0 +1,71 @@
+#include <stdlib.h>
+#include <string.h>
+#include "account_index.h"
+
+// FNV-1a over the account number, never returns 0 since 0 marks an empty slot
+static unsigned int hash_account_number(const char* account_number)
+{
+    unsigned int h = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)account_number; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+int account_index_build(account_index* index, Account* accounts, int num_accounts)
+{
+    unsigned int size = 16;
+
+    // keep the load factor at or below one half so probe chains stay short
+    while (size < (unsigned int)num_accounts * 2) {
+        size <<= 1;
+    }
+
+    index->slots = calloc(size, sizeof(index_slot));
+    if (index->slots == NULL) {
+        return -1;
+    }
+    index->mask = size - 1;
+    index->accounts = accounts;
+
+    for (int i = 0; i < num_accounts; i++) {
+        unsigned int h = hash_account_number(accounts[i].account_number);
+        unsigned int pos = h & index->mask;
+
+        while (index->slots[pos].hash != 0) {
+            pos = (pos + 1) & index->mask;
+        }
+        index->slots[pos].hash = h;
+        index->slots[pos].account = i;
+    }
+
+    return 0;
+}
+
+int account_index_find(const account_index* index, const char* account_number)
+{
+    unsigned int h = hash_account_number(account_number);
+    unsigned int pos = h & index->mask;
+
+    while (index->slots[pos].hash != 0) {
+        if (index->slots[pos].hash == h) {
+            int i = index->slots[pos].account;
+            if (strcmp(index->accounts[i].account_number, account_number) == 0) {
+                return i;
+            }
+        }
+        pos = (pos + 1) & index->mask;
+    }
+
+    return -1;
+}
+
+void account_index_free(account_index* index)
+{
+    if (index == NULL) return;
+
+    free(index->slots);
+    index->slots = NULL;
+    index->mask = 0;
+}
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "money.h"
+
+// Writes the digits of value to text, returns their count
+static int format_digits(char* text, uint64_t value)
+{
+    char digits[20];
+    int length = 0;
+
+    do {
+        digits[length++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    for (int i = 0; i < length; i++) {
+        text[i] = digits[length - 1 - i];
+    }
+    return length;
+}
+
+// Writes [-]units.cc for a count of cents, the sign chosen by the caller
+static int format_cents(char* text, int negative, uint64_t cents)
+{
+    int length = 0;
+
+    if (negative) {
+        text[length++] = '-';
+    }
+    length += format_digits(text + length, cents / 100);
+    text[length++] = '.';
+    text[length++] = '0' + cents / 10 % 10;
+    text[length++] = '0' + cents % 10;
+    text[length] = '\0';
+    return length;
+}
+
+#ifdef FIXED_POINT
+
+// Parses a decimal number into an integer scaled by scale (a power of ten),
+// rounding half up on the first digit that does not fit
+static int64_t parse_scaled(const char* text, int64_t scale)
+{
+    const char* p = text;
+    int64_t value = 0;
+    int negative = 0;
+
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (*p == '-' || *p == '+') {
+        negative = *p == '-';
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        value = value * 10 + (*p++ - '0');
+    }
+    value *= scale;
+
+    if (*p == '.') {
+        p++;
+        for (int64_t digit = scale / 10; digit > 0 && *p >= '0' && *p <= '9'; digit /= 10) {
+            value += (*p++ - '0') * digit;
+        }
+        if (*p >= '5' && *p <= '9') {
+            value++;
+        }
+    }
+
+    return negative ? -value : value;
+}
+
+money_t money_parse(const char* text)
+{
+    return parse_scaled(text, 100);
+}
+
+rate_t rate_parse(const char* text)
+{
+    return parse_scaled(text, RATE_SCALE);
+}
+
+money_t money_reward(money_t tracter, rate_t rate)
+{
+    __int128 scaled = (__int128)tracter * rate;
+    __int128 half = RATE_SCALE / 2;
+
+    return (money_t)(scaled >= 0 ? (scaled + half) / RATE_SCALE : (scaled - half) / RATE_SCALE);
+}
+
+int money_format(char* text, money_t m)
+{
+    return format_cents(text, m < 0, m < 0 ? 0 - (uint64_t)m : (uint64_t)m);
+}
+
+#else
+
+// Plain decimals with at most 15 significant digits are their digits divided by
+// a power of ten. Both are exact doubles, and one correctly rounded division
+// gives the same double atof does. Anything else goes to atof.
+static double parse_decimal(const char* text)
+{
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                                    1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    const char* p = text;
+    int64_t digits = 0;
+    int num_digits = 0, decimals = 0, negative = 0;
+
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (*p == '-' || *p == '+') {
+        negative = *p == '-';
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        digits = digits * 10 + (*p++ - '0');
+        num_digits++;
+    }
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            digits = digits * 10 + (*p++ - '0');
+            num_digits++;
+            decimals++;
+        }
+    }
+    if (num_digits == 0 || num_digits > 15 || (*p != '\0' && *p != '\n' && *p != '\r' && *p != ' ')) {
+        return atof(text);
+    }
+
+    double value = digits / powers[decimals];
+    return negative ? -value : value;
+}
+
+money_t money_parse(const char* text)
+{
+    return parse_decimal(text);
+}
+
+rate_t rate_parse(const char* text)
+{
+    return parse_decimal(text);
+}
+
+money_t money_reward(money_t tracter, rate_t rate)
+{
+    return tracter * rate;
+}
+
+// %.2f rounds the exact binary value of m half to even. m is mantissa * 2^shift,
+// so m * 100 is the integer mantissa * 100 shifted, and the bits shifted out
+// decide the rounding exactly. Values of 2^55 and up, infinities and NaNs are
+// left to snprintf.
+int money_format(char* text, money_t m)
+{
+    uint64_t bits;
+    memcpy(&bits, &m, sizeof(bits));
+
+    int negative = bits >> 63;
+    int exponent = (bits >> 52) & 0x7ff;
+    uint64_t cents = 0;
+
+    if (exponent > 1077) {
+        return snprintf(text, MONEY_TEXT_MAX, "%.2f", m);
+    }
+    if (exponent > 0) {
+        uint64_t scaled = ((bits & ((1ULL << 52) - 1)) | (1ULL << 52)) * 100;   // below 2^60
+        int shift = exponent - 1075;
+
+        if (shift >= 0) {
+            cents = scaled << shift;
+        } else if (shift > -61) {
+            uint64_t rest = scaled & ((1ULL << -shift) - 1);
+            uint64_t half = 1ULL << (-shift - 1);
+
+            cents = scaled >> -shift;
+            if (rest > half || (rest == half && (cents & 1))) {
+                cents++;
+            }
+        }
+        // with a shift of -61 or less m * 100 is below a half and rounds to 0
+    }
+    return format_cents(text, negative, cents);
+}
+
+#endif
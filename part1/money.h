@@ -0,0 +1,54 @@
+#ifndef MONEY_H_
+#define MONEY_H_
+
+#include <stdint.h>
+
+//Balances, amounts and reward rates are doubles by default. Building with
+//-DFIXED_POINT (make FIXED_POINT=1) switches them to integer cents and rates
+//scaled by RATE_SCALE, so sums are exact and independent of the order the
+//workers apply them in.
+
+#ifdef FIXED_POINT
+
+typedef int64_t money_t;        // integer cents
+typedef int64_t rate_t;         // reward rate * RATE_SCALE
+
+#define RATE_SCALE 1000000LL
+
+#define MONEY_FMT "%s%lld.%02lld"
+#define MONEY_ARGS(m) ((m) < 0 ? "-" : ""), (long long)((m) < 0 ? -(m) : (m)) / 100, \
+                      (long long)((m) < 0 ? -(m) : (m)) % 100
+
+#define money_from_cents(cents) ((money_t)(cents))
+#define money_to_cents(m) ((int64_t)(m))
+
+#else
+
+typedef double money_t;
+typedef double rate_t;
+
+#define MONEY_FMT "%.2f"
+#define MONEY_ARGS(m) (m)
+
+// cents / 100.0 rounds to the same double atof gives for the text amount
+#define money_from_cents(cents) ((cents) / 100.0)
+#define money_to_cents(m) ((int64_t)((m) * 100.0 + ((m) < 0 ? -0.5 : 0.5)))
+
+#endif
+
+//parses a decimal amount such as "1520.75"
+money_t money_parse(const char* text);
+
+//parses a reward rate such as "0.045"
+rate_t rate_parse(const char* text);
+
+//the reward earned on a transaction tracter, rounded to the cent in fixed point
+money_t money_reward(money_t tracter, rate_t rate);
+
+#define MONEY_TEXT_MAX 320      // longest money_format text with its NUL, a %.2f of DBL_MAX
+
+//writes m NUL terminated as printf(MONEY_FMT, MONEY_ARGS(m)) would, without
+//going through printf, returns the length of the text
+int money_format(char* text, money_t m);
+
+#endif /* MONEY_H_ */
@@ -1,119 +1,143 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include "account.h"
+#include "account_header.h"
+#include "account_index.h"
+#include "output_writer.h"
+#include "phase_timer.h"
 #include "string_parser.h"
 
-void process_transactions(FILE *input, Account *accounts, int num_accounts) {
+void process_transactions(FILE *input, Account *accounts, account_index *index) {
     char buffer[256];
     while (fgets(buffer, sizeof(buffer), input)) {
-        command_line cmd = str_filler(buffer, " ");
-        if (cmd.num_token == 0) {
-            free_command_line(&cmd);
+        token_view cmd;
+        if (str_tokenize(buffer, " ", &cmd) == 0) {
             continue;
         }
 
-        char *type = cmd.command_list[0];
+        char *type = cmd.tokens[0];
 
         if (strcmp(type, "D") == 0) { // Deposit
-            char *account_num = cmd.command_list[1];
-            char *password = cmd.command_list[2];
-            double amount = atof(cmd.command_list[3]);
-
-            for (int i = 0; i < num_accounts; i++) {
-                if (strcmp(accounts[i].account_number, account_num) == 0 &&
-                    strcmp(accounts[i].password, password) == 0) {
-                    accounts[i].balance += amount;
-                    accounts[i].transaction_tracter += amount;
-                    break;
-                }
+            if (cmd.num_token < 4) continue;
+            int i = account_index_find(index, cmd.tokens[1]);
+            char *password = cmd.tokens[2];
+            money_t amount = money_parse(cmd.tokens[3]);
+
+            if (i >= 0 && strcmp(accounts[i].password, password) == 0) {
+                accounts[i].balance += amount;
+                accounts[i].transaction_tracter += amount;
             }
         } else if (strcmp(type, "W") == 0) { // Withdraw
-            char *account_num = cmd.command_list[1];
-            char *password = cmd.command_list[2];
-            double amount = atof(cmd.command_list[3]);
-
-            for (int i = 0; i < num_accounts; i++) {
-                if (strcmp(accounts[i].account_number, account_num) == 0 &&
-                    strcmp(accounts[i].password, password) == 0) {
-                    accounts[i].balance -= amount;
-                    accounts[i].transaction_tracter += amount;
-                    break;
-                }
+            if (cmd.num_token < 4) continue;
+            int i = account_index_find(index, cmd.tokens[1]);
+            char *password = cmd.tokens[2];
+            money_t amount = money_parse(cmd.tokens[3]);
+
+            if (i >= 0 && strcmp(accounts[i].password, password) == 0) {
+                accounts[i].balance -= amount;
+                accounts[i].transaction_tracter += amount;
             }
         } else if (strcmp(type, "T") == 0) { // Transfer
-            char *src_account = cmd.command_list[1];
-            char *password = cmd.command_list[2];
-            char *dest_account = cmd.command_list[3];
-            double amount = atof(cmd.command_list[4]);
-
-            for (int i = 0; i < num_accounts; i++) {
-                if (strcmp(accounts[i].account_number, src_account) == 0 &&
-                    strcmp(accounts[i].password, password) == 0) {
-                    accounts[i].balance -= amount;
-                    accounts[i].transaction_tracter += amount;
-
-                    for (int j = 0; j < num_accounts; j++) {
-                        if (strcmp(accounts[j].account_number, dest_account) == 0) {
-                            accounts[j].balance += amount;
-                            break;
-                        }
-                    }
-                    break;
+            if (cmd.num_token < 5) continue;
+            int i = account_index_find(index, cmd.tokens[1]);
+            char *password = cmd.tokens[2];
+            money_t amount = money_parse(cmd.tokens[4]);
+
+            if (i >= 0 && strcmp(accounts[i].password, password) == 0) {
+                accounts[i].balance -= amount;
+                accounts[i].transaction_tracter += amount;
+
+                int j = account_index_find(index, cmd.tokens[3]);
+                if (j >= 0) {
+                    accounts[j].balance += amount;
                 }
             }
         }
 
-        free_command_line(&cmd);
     }
 }
 
 void apply_rewards(Account *accounts, int num_accounts) {
     for (int i = 0; i < num_accounts; i++) {
-        accounts[i].balance += accounts[i].transaction_tracter * accounts[i].reward_rate;
+        accounts[i].balance += money_reward(accounts[i].transaction_tracter, accounts[i].reward_rate);
     }
 }
 
-void write_output(FILE *output, Account *accounts, int num_accounts) {
-    for (int i = 0; i < num_accounts; i++) {
-        fprintf(output, "%d balance:\t%.2f\n\n", i, accounts[i].balance); // Add blank line for formatting
-    }
+int write_output(const char *path, Account *accounts, int num_accounts) {
+    // one thread like the rest of part1, the writer still skips printf per account
+    return output_write(path, &accounts[0].balance, sizeof(Account), num_accounts, 1);
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <input_file>\n", argv[0]);
+    int print_phases = 0;
+    int opt;
+    phase_timer phases;
+
+    phase_timer_start(&phases);
+    while ((opt = getopt(argc, argv, "P")) != -1) {
+        switch (opt) {
+        case 'P': // print per-phase times and peak RSS to stderr, for bench_suite.sh
+            print_phases = 1;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-P] <input_file>\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "Usage: %s [-P] <input_file>\n", argv[0]);
         return 1;
     }
+    const char *input_path = argv[optind];
 
-    FILE *input = fopen(argv[1], "r");
-    FILE *output = fopen("out.txt", "w");
-    if (!input || !output) {
+    FILE *input = fopen(input_path, "r");
+    if (!input) {
         perror("Error opening file");
         return 1;
     }
 
-    int num_accounts;
-    fscanf(input, "%d\n", &num_accounts);
+    account_header header;
+    if (account_header_open(&header, input_path) != 0) {
+        fprintf(stderr, "Error reading account header of %s\n", input_path);
+        return 1;
+    }
+    int num_accounts = header.num_accounts;
+
+    Account *accounts = calloc(num_accounts > 0 ? num_accounts : 1, sizeof(Account));
 
-    Account *accounts = malloc(sizeof(Account) * num_accounts);
+    // part1 stays single-threaded, the header is parsed on this thread too
+    if (account_header_parse(&header, accounts, &accounts[0].balance, sizeof(Account), 1) != 0) {
+        fprintf(stderr, "Malformed account header in %s\n", input_path);
+        return 1;
+    }
+    fseek(input, header.body, SEEK_SET);
+    account_header_close(&header);
 
-    for (int i = 0; i < num_accounts; i++) {
-        fscanf(input, "index %*d\n");
-        fscanf(input, "%s\n", accounts[i].account_number);
-        fscanf(input, "%s\n", accounts[i].password);
-        fscanf(input, "%lf\n", &accounts[i].balance);
-        fscanf(input, "%lf\n", &accounts[i].reward_rate);
-        accounts[i].transaction_tracter = 0.0;
+    account_index index;
+    if (account_index_build(&index, accounts, num_accounts) != 0) {
+        perror("Account index allocation failed");
+        return 1;
     }
+    phase_timer_mark(&phases, PHASE_HEADER);
 
-    process_transactions(input, accounts, num_accounts);
+    process_transactions(input, accounts, &index);
+    phase_timer_mark(&phases, PHASE_PROCESS);
     apply_rewards(accounts, num_accounts);
-    write_output(output, accounts, num_accounts);
+    phase_timer_mark(&phases, PHASE_REWARDS);
+    if (write_output("out.txt", accounts, num_accounts) != 0) {
+        perror("Error writing out.txt");
+        return 1;
+    }
+    phase_timer_mark(&phases, PHASE_OUTPUT);
+    if (print_phases) {
+        phase_timer_report(&phases, stderr);
+    }
 
+    account_index_free(&index);
     free(accounts);
     fclose(input);
-    fclose(output);
 
     return 0;
 }
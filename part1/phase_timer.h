@@ -0,0 +1,37 @@
+#ifndef PHASE_TIMER_H_
+#define PHASE_TIMER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+//the phases every bank variant goes through, in order
+typedef enum
+{
+    PHASE_HEADER,               // account header (or snapshot) loaded and indexed
+    PHASE_PROCESS,              // transactions applied
+    PHASE_REWARDS,              // rewards applied
+    PHASE_OUTPUT,               // out.txt written
+    NUM_PHASES
+}phase;
+
+typedef struct
+{
+    int64_t mark_ns;            // monotonic time of the last phase_timer_mark
+    int64_t ns[NUM_PHASES];
+}phase_timer;
+
+//starts the clock for the first phase
+void phase_timer_start(phase_timer* timer);
+
+//charges the time since the previous mark (or the start) to p
+void phase_timer_mark(phase_timer* timer, phase p);
+
+//charges ns to p without moving the mark, for work that overlaps another phase
+void phase_timer_add(phase_timer* timer, phase p, int64_t ns);
+
+//prints one line "phases header_ms=... process_ms=... rewards_ms=... output_ms=...
+//peak_rss_kb=..." for the benchmark driver. The peak RSS is this process's,
+//children such as part2's auditor are not included.
+void phase_timer_report(const phase_timer* timer, FILE* out);
+
+#endif /* PHASE_TIMER_H_ */
@@ -13,6 +13,15 @@ typedef struct
     int num_token;
 }command_line;
 
+#define MAX_TOKENS 8
+
+//token views into a line buffer owned by the caller, nothing in here is heap allocated
+typedef struct
+{
+    char* tokens[MAX_TOKENS];
+    int num_token;
+}token_view;
+
 //this functions returns the number of tokens needed for the string array
 //based on the delimeter
 int count_token (char* buf, const char* delim);
@@ -27,4 +36,9 @@ void free_command_line(command_line* command);
 
 char *clean_spaces(char *str);
 
+//This function tokenizes buf in place: delimeters and the trailing newline are
+//overwritten with '\0' and the views point into buf, so they stay valid only as
+//long as buf does. At most MAX_TOKENS tokens are kept, it returns num_token.
+int str_tokenize(char* buf, const char* delim, token_view* view);
+
 #endif /* STRING_PARSER_H_ */
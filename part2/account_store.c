@@ -0,0 +1,37 @@
+#include <stdlib.h>
+#include <string.h>
+#include "account_store.h"
+
+int account_store_init(account_store* store, int num_accounts)
+{
+    size_t state_size = sizeof(account_state) * (num_accounts > 0 ? num_accounts : 1);
+
+    store->num_accounts = num_accounts;
+    store->accounts = calloc(num_accounts > 0 ? num_accounts : 1, sizeof(Account));
+    store->state = aligned_alloc(CACHE_LINE, state_size);
+    if (store->accounts == NULL || store->state == NULL) {
+        free(store->accounts);
+        free(store->state);
+        return -1;
+    }
+
+    memset(store->state, 0, state_size);
+    for (int i = 0; i < num_accounts; i++) {
+        pthread_mutex_init(&store->state[i].lock, NULL);
+    }
+    return 0;
+}
+
+void account_store_free(account_store* store)
+{
+    if (store == NULL) return;
+
+    for (int i = 0; i < store->num_accounts; i++) {
+        pthread_mutex_destroy(&store->state[i].lock);
+    }
+    free(store->state);
+    free(store->accounts);
+    store->state = NULL;
+    store->accounts = NULL;
+    store->num_accounts = 0;
+}
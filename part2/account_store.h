@@ -0,0 +1,34 @@
+#ifndef ACCOUNT_STORE_H_
+#define ACCOUNT_STORE_H_
+
+#include <pthread.h>
+#include "account.h"
+#include "money.h"
+
+#define CACHE_LINE 64
+
+//the state workers write on every transaction, padded to a cache line so two
+//workers updating neighbouring accounts never share a line
+typedef struct
+{
+    pthread_mutex_t lock;
+    money_t balance;
+    money_t transaction_tracter;
+} __attribute__((aligned(CACHE_LINE))) account_state;
+
+//accounts split into cold identity data and hot per-account state, both
+//indexed by the account's position in the input header
+typedef struct
+{
+    Account* accounts;
+    account_state* state;
+    int num_accounts;
+}account_store;
+
+//allocates both arrays and initializes every lock, balances start at zero,
+//returns 0 on success
+int account_store_init(account_store* store, int num_accounts);
+
+void account_store_free(account_store* store);
+
+#endif /* ACCOUNT_STORE_H_ */
@@ -0,0 +1,230 @@
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "audit.h"
+
+// the ring is shared between processes, so these are not the _PRIVATE futex ops
+static void futex_wait(atomic_uint* word, unsigned int expected)
+{
+    syscall(SYS_futex, word, FUTEX_WAIT, expected, NULL, NULL, 0);
+}
+
+static void futex_wake(atomic_uint* word, int count)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+int audit_ring_create(audit_channel* channel)
+{
+    audit_ring* ring = mmap(NULL, sizeof(audit_ring), PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        return -1;
+    }
+
+    // a fresh anonymous mapping is zeroed, which is an empty open ring
+    channel->fd = -1;
+    channel->ring = ring;
+    return 0;
+}
+
+void audit_channel_close(audit_channel* channel)
+{
+    if (channel->ring == NULL) {
+        close(channel->fd);
+        return;
+    }
+    atomic_store(&channel->ring->closed, 1);
+    atomic_fetch_add(&channel->ring->data_futex, 1);
+    futex_wake(&channel->ring->data_futex, 1);
+}
+
+// Reserves count consecutive positions, sleeping while the auditor is a full
+// ring behind, then publishes the records slot by slot.
+static void ring_push(audit_ring* ring, const audit_record* records, size_t count)
+{
+    unsigned long long pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    for (;;) {
+        if (pos + count - atomic_load(&ring->tail) > AUDIT_RING_SLOTS) {
+            unsigned int seen = atomic_load(&ring->space_futex);
+            atomic_fetch_add(&ring->producers_sleeping, 1);
+            if (pos + count - atomic_load(&ring->tail) > AUDIT_RING_SLOTS) {
+                futex_wait(&ring->space_futex, seen);
+            }
+            atomic_fetch_sub(&ring->producers_sleeping, 1);
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak(&ring->head, &pos, pos + count)) {
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        audit_slot* slot = &ring->slots[(pos + i) & (AUDIT_RING_SLOTS - 1)];
+        slot->record = records[i];
+        atomic_store_explicit(&slot->seq, pos + i + 1, memory_order_release);
+    }
+
+    // pairs with the fence in ring_pop: either the auditor sees the seq
+    // stores above or this load sees it going to sleep, never neither
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&ring->auditor_sleeping)) {
+        atomic_fetch_add(&ring->data_futex, 1);
+        futex_wake(&ring->data_futex, 1);
+    }
+}
+
+static int ring_ready(audit_ring* ring, unsigned long long pos)
+{
+    audit_slot* slot = &ring->slots[pos & (AUDIT_RING_SLOTS - 1)];
+    return atomic_load_explicit(&slot->seq, memory_order_acquire) == pos + 1;
+}
+
+// Copies out up to max published records, sleeping while there are none.
+static size_t ring_pop(audit_ring* ring, audit_record* records, size_t max)
+{
+    unsigned long long pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t count = 0;
+
+    while (!ring_ready(ring, pos)) {
+        unsigned int seen = atomic_load(&ring->data_futex);
+        atomic_store(&ring->auditor_sleeping, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (ring_ready(ring, pos)) {
+            atomic_store(&ring->auditor_sleeping, 0);
+            break;
+        }
+        // closed is only set once every producer is done, so nothing is left
+        if (atomic_load(&ring->closed)) {
+            atomic_store(&ring->auditor_sleeping, 0);
+            if (!ring_ready(ring, pos)) {
+                return 0;
+            }
+            break;
+        }
+        futex_wait(&ring->data_futex, seen);
+        atomic_store(&ring->auditor_sleeping, 0);
+    }
+
+    while (count < max && ring_ready(ring, pos + count)) {
+        records[count] = ring->slots[(pos + count) & (AUDIT_RING_SLOTS - 1)].record;
+        count++;
+    }
+    atomic_store(&ring->tail, pos + count);
+
+    if (atomic_load(&ring->producers_sleeping)) {
+        atomic_fetch_add(&ring->space_futex, 1);
+        futex_wake(&ring->space_futex, INT32_MAX);
+    }
+    return count;
+}
+
+void audit_buffer_init(audit_buffer* buffer, audit_channel* channel)
+{
+    buffer->channel = channel;
+    buffer->count = 0;
+}
+
+void audit_log(audit_buffer* buffer, char type, const char* account_number, money_t balance, time_t when)
+{
+    audit_record* record = &buffer->records[buffer->count++];
+
+    memset(record, 0, sizeof(audit_record));
+    record->time = when;
+    record->balance = balance;
+    record->type = type;
+    strncpy(record->account_number, account_number, sizeof(record->account_number) - 1);
+
+    if (buffer->count == AUDIT_BATCH) {
+        audit_flush(buffer);
+    }
+}
+
+static atomic_ullong records_sent;
+
+void audit_flush(audit_buffer* buffer)
+{
+    atomic_fetch_add_explicit(&records_sent, buffer->count, memory_order_relaxed);
+    if (buffer->channel->ring != NULL) {
+        ring_push(buffer->channel->ring, buffer->records, buffer->count);
+        buffer->count = 0;
+        return;
+    }
+
+    const char* data = (const char*)buffer->records;
+    size_t left = buffer->count * sizeof(audit_record);
+
+    while (left > 0) {
+        ssize_t written = write(buffer->channel->fd, data, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            perror("Audit write failed");
+            break;
+        }
+        data += written;
+        left -= written;
+    }
+    buffer->count = 0;
+}
+
+unsigned long long audit_records_sent(void)
+{
+    return atomic_load_explicit(&records_sent, memory_order_relaxed);
+}
+
+size_t audit_channel_read(audit_channel* channel, audit_record* records, size_t max)
+{
+    char* data = (char*)records;
+    size_t got = 0;
+    ssize_t bytes;
+
+    if (channel->ring != NULL) {
+        return ring_pop(channel->ring, records, max);
+    }
+
+    do {
+        bytes = read(channel->fd, data, max * sizeof(audit_record));
+    } while (bytes < 0 && errno == EINTR);
+    if (bytes <= 0) {
+        return 0;
+    }
+    got = bytes;
+
+    // every write is whole records, so a partial one means the rest is still in the pipe
+    while (got % sizeof(audit_record) != 0) {
+        bytes = read(channel->fd, data + got, sizeof(audit_record) - got % sizeof(audit_record));
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes <= 0) break;
+        got += bytes;
+    }
+    return got / sizeof(audit_record);
+}
+
+void audit_format(FILE* ledger, const audit_record* records, size_t count)
+{
+    // ctime is only worth calling again when the second changes
+    static time_t last_time = -1;
+    static char stamp[32];
+
+    for (size_t i = 0; i < count; i++) {
+        const audit_record* record = &records[i];
+
+        if (record->time != last_time) {
+            time_t when = record->time;
+            last_time = when;
+            strncpy(stamp, ctime(&when), sizeof(stamp) - 1);
+        }
+        if (record->type == AUDIT_CHECK_BALANCE) {
+            fprintf(ledger, "Worker checked balance of Account %s. Balance is $" MONEY_FMT ". Check occured at %s",
+                    record->account_number, MONEY_ARGS(record->balance), stamp);
+        } else if (record->type == AUDIT_INTEREST) {
+            fprintf(ledger, "Applied interest to account %s. New Balance: $" MONEY_FMT ". Time of Update: %s",
+                    record->account_number, MONEY_ARGS(record->balance), stamp);
+        }
+    }
+}
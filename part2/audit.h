@@ -0,0 +1,93 @@
+#ifndef AUDIT_H_
+#define AUDIT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+#include <time.h>
+#include <stdatomic.h>
+#include "money.h"
+
+#define AUDIT_CHECK_BALANCE 'C'
+#define AUDIT_INTEREST 'I'
+
+#define AUDIT_PIPE_SIZE (1 << 20)   // asked of the kernel so a slow auditor does not block workers
+#define AUDIT_RING_SLOTS 65536      // power of two
+
+//one ledger event as it travels to the auditor, formatted only on the auditor's side
+typedef struct
+{
+    int64_t time;               // when the event happened
+    money_t balance;
+    uint8_t type;               // AUDIT_CHECK_BALANCE or AUDIT_INTEREST
+    char account_number[17];
+    uint8_t reserved[6];
+}audit_record;
+
+//records per flush, a flush is one write() no larger than PIPE_BUF so writes
+//from different workers never interleave inside a record
+#define AUDIT_BATCH (PIPE_BUF / sizeof(audit_record))
+
+//a ring slot, seq is the ring position the record was published for
+typedef struct
+{
+    atomic_ullong seq;
+    audit_record record;
+}audit_slot;
+
+//shared-memory ring mapped before the fork: any bank thread produces, the
+//auditor consumes. The futex words are bumped whenever a sleeper has to be
+//woken, the counters on their own cache lines keep producers and the auditor
+//off each other's lines.
+typedef struct
+{
+    atomic_ullong head __attribute__((aligned(64)));   // next position a producer reserves
+    atomic_ullong tail __attribute__((aligned(64)));   // next position the auditor reads
+    atomic_uint data_futex __attribute__((aligned(64)));
+    atomic_int auditor_sleeping;
+    atomic_int closed;
+    atomic_uint space_futex __attribute__((aligned(64)));
+    atomic_int producers_sleeping;
+    audit_slot slots[AUDIT_RING_SLOTS] __attribute__((aligned(64)));
+}audit_ring;
+
+//the bank's end of the channel to the auditor, a pipe or the shared ring
+typedef struct
+{
+    int fd;
+    audit_ring* ring;           // NULL in pipe mode
+}audit_channel;
+
+//records a thread has logged but not yet sent, one per thread
+typedef struct
+{
+    audit_channel* channel;
+    int count;
+    audit_record records[AUDIT_BATCH];
+}audit_buffer;
+
+//maps a shared ring into channel, call before fork() so both processes see it
+int audit_ring_create(audit_channel* channel);
+
+//bank side: tells the auditor no more records will come
+void audit_channel_close(audit_channel* channel);
+
+void audit_buffer_init(audit_buffer* buffer, audit_channel* channel);
+
+//appends an event, sending the buffer on once it is full
+void audit_log(audit_buffer* buffer, char type, const char* account_number, money_t balance, time_t when);
+
+//sends whatever the buffer holds
+void audit_flush(audit_buffer* buffer);
+
+//bank side: records sent by every buffer so far, each one a ledger line
+unsigned long long audit_records_sent(void);
+
+//auditor side: reads up to max whole records, returns 0 once every writer has closed
+size_t audit_channel_read(audit_channel* channel, audit_record* records, size_t max);
+
+//auditor side: writes the ledger lines for count records
+void audit_format(FILE* ledger, const audit_record* records, size_t count);
+
+#endif /* AUDIT_H_ */
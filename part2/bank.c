@@ -1,43 +1,284 @@
+#define _GNU_SOURCE // F_SETPIPE_SZ
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
 #include <time.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include "account.h"
+#include "account_header.h"
+#include "account_index.h"
+#include "account_store.h"
+#include "audit.h"
+#include "cpu_topology.h"
+#include "delta_batch.h"
+#include "input_reader.h"
+#include "money_atomic.h"
+#include "output_writer.h"
+#include "phase_timer.h"
+#include "snapshot.h"
 #include "string_parser.h"
+#include "transaction.h"
+#include "txn_dispatch.h"
+#include "txn_log.h"
+#include "txn_pipeline.h"
+#include "worker_stats.h"
 
-#define NUM_WORKERS 10
 #define CHECK_BALANCE_THRESHOLD 500
 #define MAX_CHECK_LOGS 20
+#define AUDIT_READ_RECORDS 4096     // records the auditor reads at a time
+#ifndef CHECKPOINT_BYTES
+#define CHECKPOINT_BYTES (64u << 20)    // input text between two checkpoints with -c
+#endif
+#ifndef CHECKPOINT_RECORDS
+#define CHECKPOINT_RECORDS (1u << 21)   // compiled log records between two checkpoints with -c
+#endif
+#define CHECKPOINT_CHUNKS (CHECKPOINT_BYTES / INPUT_CHUNK_SIZE > 0 ? CHECKPOINT_BYTES / INPUT_CHUNK_SIZE : 1)
+#define DISPATCH_LINE 256           // bytes per line of a dispatched text batch
+
+#if DISPATCH_BATCH % TXN_LOG_BATCH != 0
+#error "a dispatched batch has to hold whole compiled log claims"
+#endif
 
 typedef struct {
-    Account *accounts;
-    int num_accounts;
+    account_store *store;
+    account_index *index;
     FILE *input;
+    mapped_input *mapped;          // NULL unless the input was mmapped with -m
+    txn_log *log;                  // NULL unless replaying a compiled log with -b
     pthread_mutex_t *file_mutex;
-    pthread_mutex_t *account_mutexes;
+    int atomic_updates;            // -a: deposits and withdrawals skip the account lock
+    int batched;                   // -B: deposits and withdrawals are merged in per-worker batches
+    txn_dispatch *dispatch;        // -d: every account's changes run in file order, else NULL
+    txn_pipeline *pipeline;        // -q: workers apply what the parser threads queue for them, else NULL
+    int id;                        // the worker's place in the dispatch ranges and parse split, a parser's own number
+    worker_stats *stats;           // the worker's counters with WORKER_STATS, else NULL
+    int cpu;                       // -p: the CPU the worker pins itself to, else -1
 } WorkerArgs;
 
 int pipe_fd[2];
-pthread_mutex_t check_count_mutex = PTHREAD_MUTEX_INITIALIZER;
-int check_balance_count = 0;   // Global count of check balance commands
-int logged_checks = 0;         // Number of check balance logs written
+audit_channel audit_out;       // the write end of pipe_fd or the shared ring, used by every audit_buffer
+atomic_int check_balance_count;   // Global count of check balance commands
+atomic_int logged_checks;         // Number of check balance logs claimed
+
+// With -c the workers run the input one segment at a time and meet at the
+// barrier after each, where one of them writes a snapshot. Without -c the only
+// segment is the whole input.
+typedef struct {
+    const char *path;              // NULL unless -c
+    pthread_barrier_t barrier;
+    size_t end;                    // byte the fgets segment stops at (-m and -b keep theirs in the reader)
+    size_t input_pos;              // next unread byte of the fgets stream, under file_mutex
+    int done;
+    struct stat input;             // the input or compiled log the snapshots' positions are in
+    unsigned long long ledger_base; // ledger.txt lines kept from the run resumed with -r
+} checkpoint_state;
+
+checkpoint_state checkpoint = {NULL};
+
+// With -d one worker reads each batch in file order, all of them parse their
+// share of it, one groups it by partition and all of them run it. The checks a
+// batch logged are written to the ledger in file order before the next batch.
+typedef struct {
+    pthread_barrier_t barrier;
+    audit_buffer audit;            // the sampled checks, flushed once per batch
+    char *lines;                   // DISPATCH_BATCH lines of DISPATCH_LINE bytes, text input only
+    const txn_record *records;     // the batch's first record with -b
+    input_cursor cursor;           // the reading worker's place in the mmapped input
+    int count;                     // transactions in the batch, 0 once the input is used up
+} dispatch_input;
+
+dispatch_input dispatched = {.cursor = {NULL, NULL}};
+int fixed_clock = 0;           // -D: every ledger record carries audit_clock instead of the time
+time_t audit_clock;
+money_t money_flow = 0;        // Money deposited minus money withdrawn, summed by workers as they exit
+int num_workers;               // -w, as many as the CPUs the bank may run on by default
 
+int next_line(WorkerArgs *args, input_cursor *cursor, char *buffer, int size);
+void lock_account_pair(account_store *store, worker_stats *stats, int first, int second);
+void unlock_account_pair(account_store *store, int first, int second);
+money_t apply_transaction(WorkerArgs *args, delta_batch *batch, audit_buffer *audit, const transaction *txn);
 void* process_transactions_thread(void *arg);
-void apply_rewards(Account *accounts, int num_accounts);
-void write_output(Account *accounts, int num_accounts);
-void auditor_process(int read_fd);
-void log_to_pipe(const char *message);
-void log_interest_application(Account *accounts, int num_accounts);
+void* parse_stage_thread(void *arg);
+money_t execute_pipelined(WorkerArgs *args, delta_batch *batch, audit_buffer *audit);
+money_t dispatch_transactions(WorkerArgs *args);
+void log_dispatched_checks(WorkerArgs *args);
+void read_batch(WorkerArgs *args);
+void parse_dispatched(WorkerArgs *args, int position);
+void sample_checks(txn_dispatch *dispatch);
+money_t apply_entry(WorkerArgs *args, const dispatch_entry *entry);
+int next_segment(WorkerArgs *args);
+void write_checkpoint(WorkerArgs *args);
+void apply_rewards(account_store *store);
+void write_output(account_store *store);
+void auditor_process(audit_channel *channel, int resumed);
+int truncate_ledger(unsigned long long records);
+void log_interest_application(account_store *store);
+money_t total_money(account_store *store);
+time_t audit_time(void);
 
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <input_file>\n", argv[0]);
+    int use_mmap = 0;
+    const char *log_path = NULL;
+    int atomic_updates = 0;
+    int verify = 0;
+    int batched = 0;
+    int shared_audit = 0;
+    int ordered = 0;
+    const char *resume_path = NULL;
+    int pin = 0;
+    int num_parsers = 0;
+    int print_phases = 0;
+    int opt;
+    phase_timer phases;
+
+    phase_timer_start(&phases);
+    while ((opt = getopt(argc, argv, "mb:avBsdDc:r:Pw:pq:")) != -1) {
+        switch (opt) {
+        case 'm': // workers read chunks of the mmapped file instead of sharing fgets
+            use_mmap = 1;
+            break;
+        case 'b': // replay transactions from a file built by ./compile
+            log_path = optarg;
+            break;
+        case 'a': // lock-free balance updates for single-account commands
+            atomic_updates = 1;
+            break;
+        case 'v': // check no money was created or lost once the workers are done
+            verify = 1;
+            break;
+        case 'B': // fold deposits and withdrawals into per-worker deltas, merged in batches
+            batched = 1;
+            break;
+        case 's': // audit records go through a shared-memory ring instead of the pipe
+            shared_audit = 1;
+            break;
+        case 'd': // dispatch by account so every account's transactions run in file order
+            ordered = 1;
+            break;
+        case 'D': // -d with a fixed ledger clock, out.txt and ledger.txt are the same on every run
+            ordered = 1;
+            fixed_clock = 1;
+            break;
+        case 'c': // write a snapshot every checkpoint segment and once the input is done
+            checkpoint.path = optarg;
+            break;
+        case 'r': // resume from a snapshot of the same input, ledger.txt is cut back to it and continued
+            resume_path = optarg;
+            break;
+        case 'P': // print per-phase times and peak RSS to stderr, for bench_suite.sh
+            print_phases = 1;
+            break;
+        case 'w': // number of worker threads
+            num_workers = atoi(optarg);
+            if (num_workers < 1) {
+                fprintf(stderr, "-w needs a positive number of workers\n");
+                return 1;
+            }
+            break;
+        case 'p': // pin the workers and the auditor to distinct cores, filling one NUMA node first
+            pin = 1;
+            break;
+        case 'q': // parse on this many threads of their own, the -w workers only apply what they queue
+            num_parsers = atoi(optarg);
+            if (num_parsers < 1) {
+                fprintf(stderr, "-q needs a positive number of parser threads\n");
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-m] [-a] [-B] [-v] [-s] [-d | -D] [-b compiled_log] [-c snapshot] [-r snapshot] [-w workers] [-q parsers] [-p] [-P] <input_file>\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "Usage: %s [-m] [-a] [-B] [-v] [-s] [-d | -D] [-b compiled_log] [-c snapshot] [-r snapshot] [-w workers] [-q parsers] [-p] [-P] <input_file>\n", argv[0]);
+        return 1;
+    }
+    const char *input_path = argv[optind];
+    if (ordered && (atomic_updates || batched || checkpoint.path != NULL)) {
+        fprintf(stderr, "-d runs every account's changes in order without locks, it cannot be combined with -a, -B or -c\n");
+        return 1;
+    }
+    if (num_parsers > 0 && (ordered || log_path != NULL || checkpoint.path != NULL)) {
+        fprintf(stderr, "-q pipelines text parsing, it cannot be combined with -d, -b or -c\n");
         return 1;
     }
+    if (num_workers == 0) {
+        num_workers = cpu_count();
+        if (pin && num_workers > 1) {
+            num_workers--; // -p keeps a core free for the auditor
+        }
+    }
+    cpu_topology topology = {NULL, 0};
+    if (pin && cpu_topology_load(&topology) != 0) {
+        perror("Error reading the CPU topology");
+        return 1;
+    }
+    if (fixed_clock) {
+        // SOURCE_DATE_EPOCH as in reproducible builds, else the input's modification time
+        const char *epoch = getenv("SOURCE_DATE_EPOCH");
+        struct stat st;
+
+        if (epoch != NULL) {
+            audit_clock = strtoll(epoch, NULL, 10);
+        } else if (stat(input_path, &st) == 0) {
+            audit_clock = st.st_mtime;
+        }
+    }
+
+    // a snapshot is checked against the input before the auditor touches the ledger
+    if (stat(log_path != NULL ? log_path : input_path, &checkpoint.input) != 0) {
+        perror("Error opening file");
+        return 1;
+    }
+    snapshot snap = {NULL};
+    if (resume_path != NULL) {
+        if (snapshot_open(&snap, resume_path) != 0) {
+            fprintf(stderr, "Error opening snapshot %s: missing, corrupt or written by a build with other money types\n",
+                    resume_path);
+            return 1;
+        }
+        if (snap.header->compiled != (log_path != NULL)) {
+            fprintf(stderr, "Snapshot %s was written %s a compiled log\n", resume_path,
+                    snap.header->compiled ? "replaying" : "without");
+            return 1;
+        }
+        account_header header;
+        if (snap.header->input_size != (uint64_t)checkpoint.input.st_size ||
+            snap.header->input_mtime != checkpoint.input.st_mtime ||
+            (log_path == NULL && snap.header->position > snap.header->input_size) ||
+            account_header_open(&header, input_path) != 0) {
+            fprintf(stderr, "Snapshot %s was not written for %s\n", resume_path, log_path != NULL ? log_path : input_path);
+            return 1;
+        }
+        int header_accounts = header.num_accounts;
+        account_header_close(&header);
+        if ((uint32_t)header_accounts != snap.header->num_accounts) {
+            fprintf(stderr, "Snapshot %s holds %u accounts, %s has %d\n", resume_path, snap.header->num_accounts,
+                    input_path, header_accounts);
+            return 1;
+        }
+        if (truncate_ledger(snap.header->ledger_records) != 0) {
+            fprintf(stderr, "ledger.txt holds fewer than the %llu records written before snapshot %s\n",
+                    (unsigned long long)snap.header->ledger_records, resume_path);
+            return 1;
+        }
+        checkpoint.ledger_base = snap.header->ledger_records;
+    }
 
-    if (pipe(pipe_fd) == -1) {
+    if (shared_audit) {
+        if (audit_ring_create(&audit_out) != 0) {
+            perror("Audit ring creation failed");
+            return 1;
+        }
+    } else if (pipe(pipe_fd) == -1) {
         perror("Pipe creation failed");
         return 1;
     }
@@ -49,211 +290,775 @@ int main(int argc, char *argv[]) {
     }
 
     if (pid == 0) {
-        close(pipe_fd[1]);
-        auditor_process(pipe_fd[0]);
+        audit_channel audit_in = audit_out;
+        if (pin) { // slot 0 is the auditor's, the workers and parsers take the slots after it
+            cpu_pin_thread(cpu_topology_cpu(&topology, 0));
+        }
+        if (!shared_audit) {
+            close(pipe_fd[1]);
+            audit_in.fd = pipe_fd[0];
+        }
+        auditor_process(&audit_in, resume_path != NULL);
         exit(0);
     }
 
-    close(pipe_fd[0]);
+    if (!shared_audit) {
+        close(pipe_fd[0]);
+        fcntl(pipe_fd[1], F_SETPIPE_SZ, AUDIT_PIPE_SIZE); // best effort, the default 64K still works
+        audit_out.fd = pipe_fd[1];
+    }
 
-    FILE *input = fopen(argv[1], "r");
+    FILE *input = fopen(input_path, "r");
     if (!input) {
         perror("Error opening file");
         return 1;
     }
 
+    account_store store;
+    size_t body;               // where the transactions start (or resume), a record index with -b
     int num_accounts;
-    fscanf(input, "%d\n", &num_accounts);
 
-    Account *accounts = malloc(sizeof(Account) * num_accounts);
-    pthread_mutex_t *account_mutexes = malloc(sizeof(pthread_mutex_t) * num_accounts);
-    for (int i = 0; i < num_accounts; i++) {
-        fscanf(input, "index %*d\n");
-        fscanf(input, "%s\n", accounts[i].account_number);
-        fscanf(input, "%s\n", accounts[i].password);
-        fscanf(input, "%lf\n", &accounts[i].balance);
-        fscanf(input, "%lf\n", &accounts[i].reward_rate);
-        accounts[i].transaction_tracter = 0.0;
-        pthread_mutex_init(&account_mutexes[i], NULL);
+    if (resume_path != NULL) {
+        num_accounts = snap.header->num_accounts;
+        if (account_store_init(&store, num_accounts) != 0) {
+            perror("Account store allocation failed");
+            return 1;
+        }
+        snapshot_restore(&snap, &store);
+        body = snap.header->position;
+        atomic_store(&check_balance_count, snap.header->check_balance_count);
+        atomic_store(&logged_checks, snap.header->logged_checks);
+        snapshot_close(&snap);
+    } else {
+        account_header header;
+        if (account_header_open(&header, input_path) != 0) {
+            fprintf(stderr, "Error reading account header of %s\n", input_path);
+            return 1;
+        }
+        num_accounts = header.num_accounts;
+
+        if (account_store_init(&store, num_accounts) != 0) {
+            perror("Account store allocation failed");
+            return 1;
+        }
+        if (account_header_parse(&header, store.accounts, &store.state[0].balance, sizeof(account_state),
+                                 num_workers) != 0) {
+            fprintf(stderr, "Malformed account header in %s\n", input_path);
+            return 1;
+        }
+        body = log_path != NULL ? 0 : header.body;
+        account_header_close(&header);
+    }
+    Account *accounts = store.accounts;
+
+    if (log_path == NULL) {
+        fseek(input, body, SEEK_SET); // workers read the transactions with fgets from here
+    }
+    checkpoint.input_pos = body;
+    checkpoint.end = checkpoint.path != NULL ? body + CHECKPOINT_BYTES : SIZE_MAX;
+
+    account_index index;
+    if (account_index_build(&index, accounts, num_accounts) != 0) {
+        perror("Account index allocation failed");
+        return 1;
+    }
+    money_t opening_total = total_money(&store);
+    phase_timer_mark(&phases, PHASE_HEADER);
+
+    mapped_input mapped;
+    if (use_mmap && mapped_input_open(&mapped, input_path, body) != 0) {
+        perror("Error mapping input file");
+        return 1;
+    }
+
+    txn_log log;
+    if (log_path != NULL && txn_log_open(&log, log_path, num_accounts) != 0) {
+        fprintf(stderr, "Error opening compiled log %s: missing, corrupt or built for another account header\n",
+                log_path);
+        return 1;
+    }
+    if (log_path != NULL && body > log.num_records) {
+        fprintf(stderr, "Snapshot %s was not written for %s\n", resume_path, log_path);
+        return 1;
+    }
+
+    if (checkpoint.path != NULL) {
+        pthread_barrier_init(&checkpoint.barrier, NULL, num_workers);
+        if (use_mmap) {
+            mapped_input_segment(&mapped, 0, CHECKPOINT_CHUNKS);
+        }
+    }
+    if (log_path != NULL) {
+        txn_log_segment(&log, body, checkpoint.path != NULL ? body + CHECKPOINT_RECORDS : SIZE_MAX);
     }
 
     pthread_mutex_t file_mutex;
     pthread_mutex_init(&file_mutex, NULL);
 
-    pthread_t workers[NUM_WORKERS];
-    WorkerArgs args = {accounts, num_accounts, input, &file_mutex, account_mutexes};
+    txn_dispatch dispatch;
+    if (ordered) {
+        if (txn_dispatch_init(&dispatch, num_workers) != 0 ||
+            (log_path == NULL && (dispatched.lines = malloc((size_t)DISPATCH_BATCH * DISPATCH_LINE)) == NULL)) {
+            perror("Dispatcher allocation failed");
+            return 1;
+        }
+        pthread_barrier_init(&dispatched.barrier, NULL, num_workers);
+        audit_buffer_init(&dispatched.audit, &audit_out);
+    }
+
+    txn_pipeline pipeline;
+    if (num_parsers > 0 && txn_pipeline_init(&pipeline, num_parsers, num_workers) != 0) {
+        perror("Pipeline allocation failed");
+        return 1;
+    }
+
+    // the workers come first, then the -q parsers
+    int num_threads = num_workers + num_parsers;
+    pthread_t *workers = malloc(sizeof(pthread_t) * num_threads);
+    WorkerArgs *worker_args = malloc(sizeof(WorkerArgs) * num_threads);
+    if (workers == NULL || worker_args == NULL) {
+        perror("Worker allocation failed");
+        return 1;
+    }
+    WorkerArgs args = {&store, &index, input, use_mmap ? &mapped : NULL,
+                       log_path != NULL ? &log : NULL, &file_mutex, atomic_updates, batched,
+                       ordered ? &dispatch : NULL, num_parsers > 0 ? &pipeline : NULL, -1, NULL, -1};
 
-    for (int i = 0; i < NUM_WORKERS; i++) {
-        pthread_create(&workers[i], NULL, process_transactions_thread, &args);
+    // before the workers exist, they inherit the blocked SIGUSR1
+    if (worker_stats_start(num_threads) != 0) {
+        perror("Worker stats allocation failed");
+        return 1;
+    }
+    for (int i = 0; i < num_threads; i++) {
+        worker_args[i] = args;
+        worker_args[i].id = i < num_workers ? i : i - num_workers;
+        worker_args[i].stats = worker_stats_slot(i);
+        worker_args[i].cpu = pin ? cpu_topology_cpu(&topology, i + 1) : -1;
+        pthread_create(&workers[i], NULL, i < num_workers ? process_transactions_thread : parse_stage_thread,
+                       &worker_args[i]);
     }
 
-    for (int i = 0; i < NUM_WORKERS; i++) {
+    for (int i = 0; i < num_threads; i++) {
         pthread_join(workers[i], NULL);
     }
+    phase_timer_mark(&phases, PHASE_PROCESS);
+    worker_stats_finish();
 
-    apply_rewards(accounts, num_accounts);
-    write_output(accounts, num_accounts);
-    log_interest_application(accounts, num_accounts);
+    int status = 0;
+    if (verify) {
+        money_t expected = opening_total + money_flow;
+        money_t actual = total_money(&store);
+        money_t drift = actual > expected ? actual - expected : expected - actual;
 
-    close(pipe_fd[1]);
+        if (drift > MONEY_TOLERANCE(expected)) {
+            fprintf(stderr, "Money invariant broken: expected $" MONEY_FMT " in all accounts, found $" MONEY_FMT "\n",
+                    MONEY_ARGS(expected), MONEY_ARGS(actual));
+            status = 2;
+        }
+    }
+
+    apply_rewards(&store);
+    phase_timer_mark(&phases, PHASE_REWARDS);
+    write_output(&store);
+    phase_timer_mark(&phases, PHASE_OUTPUT);
+    log_interest_application(&store);
+
+    audit_channel_close(&audit_out);
+    waitpid(pid, NULL, 0); // ledger.txt is complete once the bank exits
+    if (print_phases) {
+        phase_timer_report(&phases, stderr);
+    }
+    if (checkpoint.path != NULL) {
+        pthread_barrier_destroy(&checkpoint.barrier);
+    }
+    if (ordered) {
+        pthread_barrier_destroy(&dispatched.barrier);
+        free(dispatched.lines);
+        txn_dispatch_free(&dispatch);
+    }
+    if (num_parsers > 0) {
+        txn_pipeline_free(&pipeline);
+    }
     pthread_mutex_destroy(&file_mutex);
-    for (int i = 0; i < num_accounts; i++) {
-        pthread_mutex_destroy(&account_mutexes[i]);
+    if (use_mmap) {
+        mapped_input_close(&mapped);
+    }
+    if (log_path != NULL) {
+        txn_log_close(&log);
     }
-    free(account_mutexes);
-    free(accounts);
+    account_index_free(&index);
+    account_store_free(&store);
+    free(workers);
+    free(worker_args);
+    cpu_topology_free(&topology);
     fclose(input);
-    return 0;
+    return status;
 }
 
-void auditor_process(int read_fd) {
-    FILE *ledger = fopen("ledger.txt", "w");
+// Cuts ledger.txt back to its first records lines, the ones logged before the
+// snapshot being resumed, so the resumed run does not log the rest twice.
+// Returns -1 if it holds fewer.
+int truncate_ledger(unsigned long long records) {
+    FILE *ledger = fopen("ledger.txt", "r+");
+    if (ledger == NULL) {
+        return records == 0 ? 0 : -1;
+    }
+
+    static char block[1 << 16];
+    unsigned long long lines = 0;
+    off_t length = 0;
+    size_t got;
+
+    while (lines < records && (got = fread(block, 1, sizeof(block), ledger)) > 0) {
+        const char *p = block;
+        const char *newline;
+
+        while (lines < records && (newline = memchr(p, '\n', block + got - p)) != NULL) {
+            p = newline + 1;
+            lines++;
+        }
+        length += lines < records ? (off_t)got : p - block;
+    }
+
+    int status = lines == records && ftruncate(fileno(ledger), length) == 0 ? 0 : -1;
+    fclose(ledger);
+    return status;
+}
+
+// With -r the ledger was cut back by truncate_ledger and is added to
+void auditor_process(audit_channel *channel, int resumed) {
+    FILE *ledger = fopen("ledger.txt", resumed ? "a" : "w");
     if (!ledger) {
         perror("Failed to open ledger.txt");
         exit(1);
     }
 
-    char buffer[256];
-    ssize_t bytes_read;
-    while ((bytes_read = read(read_fd, buffer, sizeof(buffer) - 1)) > 0) {
-        buffer[bytes_read] = '\0';
-        fprintf(ledger, "%s", buffer);
+    // the ledger is written in large blocks, one read brings in many records
+    static char ledger_buffer[1 << 16];
+    static audit_record records[AUDIT_READ_RECORDS];
+    size_t count;
+
+    setvbuf(ledger, ledger_buffer, _IOFBF, sizeof(ledger_buffer));
+    while ((count = audit_channel_read(channel, records, AUDIT_READ_RECORDS)) > 0) {
+        audit_format(ledger, records, count);
     }
 
     fclose(ledger);
 }
 
+// Reads the next transaction line into buffer, returns 0 at the end of the input.
+// In mmap mode the worker walks its own chunk and takes no lock per line.
+int next_line(WorkerArgs *args, input_cursor *cursor, char *buffer, int size) {
+    if (args->mapped != NULL) {
+        return mapped_input_next_line(args->mapped, cursor, buffer, size);
+    }
+
+    STATS_LOCK(args->stats, file_wait_ns, args->file_mutex);
+    if (checkpoint.input_pos >= checkpoint.end) { // the rest belongs to the next segment
+        pthread_mutex_unlock(args->file_mutex);
+        return 0;
+    }
+    char *line = fgets(buffer, size, args->input);
+    if (line != NULL) {
+        checkpoint.input_pos += strlen(line);
+    }
+    pthread_mutex_unlock(args->file_mutex);
+    return line != NULL;
+}
+
+// Adds delta to a hot account field. With -a every write is atomic, since
+// lockless deposits and withdrawals race with transfers holding the lock.
+// Otherwise the caller holds the lock and the write only has to be untorn for
+// balance checks, which read without one.
+static inline void add_money(const WorkerArgs *args, money_t *field, money_t delta) {
+    if (args->atomic_updates) {
+        money_atomic_add(field, delta);
+    } else {
+        money_atomic_store(field, *field + delta);
+    }
+}
+
+// Locks both accounts of a transfer in index order, so two transfers going
+// opposite ways between the same accounts can never each hold one lock and
+// wait on the other
+void lock_account_pair(account_store *store, worker_stats *stats, int first, int second) {
+    if (first > second) {
+        int swap = first;
+        first = second;
+        second = swap;
+    }
+    STATS_LOCK(stats, account_wait_ns, &store->state[first].lock);
+    if (second != first) {
+        STATS_LOCK(stats, account_wait_ns, &store->state[second].lock);
+    }
+}
+
+void unlock_account_pair(account_store *store, int first, int second) {
+    pthread_mutex_unlock(&store->state[first].lock);
+    if (second != first) {
+        pthread_mutex_unlock(&store->state[second].lock);
+    }
+}
+
+// Applies one resolved transaction under the per-account locks, deposits and
+// withdrawals take no lock at all with -a. With a batch they only land in the
+// worker's pending deltas until the batch is merged. Sampled balance checks go
+// to the worker's audit buffer. Returns how much money entered (or left, when
+// negative) the bank, which is what the -v check adds up.
+money_t apply_transaction(WorkerArgs *args, delta_batch *batch, audit_buffer *audit, const transaction *txn) {
+    account_state *src;
+
+    if (txn->src < 0) {
+        return 0;
+    }
+    src = &args->store->state[txn->src];
+
+    if (batch != NULL && (txn->type == 'D' || txn->type == 'W') && txn->authorized) {
+        money_t change = txn->type == 'D' ? txn->amount : -txn->amount;
+        if (delta_batch_add(batch, txn->src, change, txn->amount)) {
+            delta_batch_merge(batch, args->store, args->atomic_updates);
+        }
+        return change;
+    }
+
+    if (txn->type == 'D' && txn->authorized) { // Deposit
+        if (args->atomic_updates) {
+            money_atomic_add(&src->balance, txn->amount);
+            money_atomic_add(&src->transaction_tracter, txn->amount);
+        } else {
+            STATS_LOCK(args->stats, account_wait_ns, &src->lock);
+            add_money(args, &src->balance, txn->amount);
+            add_money(args, &src->transaction_tracter, txn->amount);
+            pthread_mutex_unlock(&src->lock);
+        }
+        return txn->amount;
+    } else if (txn->type == 'W' && txn->authorized) { // Withdraw
+        if (args->atomic_updates) {
+            money_atomic_add(&src->balance, -txn->amount);
+            money_atomic_add(&src->transaction_tracter, txn->amount);
+        } else {
+            STATS_LOCK(args->stats, account_wait_ns, &src->lock);
+            add_money(args, &src->balance, -txn->amount);
+            add_money(args, &src->transaction_tracter, txn->amount);
+            pthread_mutex_unlock(&src->lock);
+        }
+        return -txn->amount;
+    } else if (txn->type == 'T' && txn->authorized) { // Transfer
+        if (txn->dest < 0) { // unknown destination, the debit still goes through
+            STATS_LOCK(args->stats, account_wait_ns, &src->lock);
+            add_money(args, &src->balance, -txn->amount);
+            add_money(args, &src->transaction_tracter, txn->amount);
+            pthread_mutex_unlock(&src->lock);
+            return -txn->amount;
+        }
+
+        // both accounts stay locked so no other update lands between the debit and the credit
+        account_state *dest = &args->store->state[txn->dest];
+        lock_account_pair(args->store, args->stats, txn->src, txn->dest);
+        add_money(args, &src->balance, -txn->amount);
+        add_money(args, &src->transaction_tracter, txn->amount);
+        add_money(args, &dest->balance, txn->amount);
+        unlock_account_pair(args->store, txn->src, txn->dest);
+    } else if (txn->type == 'C') { // Check Balance
+        // No mutex: every balance write is a single untorn store, so one load
+        // sees a balance the account really had. Each multiple of the threshold
+        // belongs to exactly one check, and the first MAX_CHECK_LOGS multiples
+        // to claim a log slot are the ones written.
+        int count = atomic_fetch_add_explicit(&check_balance_count, 1, memory_order_relaxed) + 1;
+        if (count % CHECK_BALANCE_THRESHOLD == 0 &&
+            atomic_fetch_add_explicit(&logged_checks, 1, memory_order_relaxed) < MAX_CHECK_LOGS) {
+            audit_log(audit, AUDIT_CHECK_BALANCE, args->store->accounts[txn->src].account_number,
+                      money_atomic_load(&src->balance), audit_time());
+        }
+    }
+    return 0;
+}
+
 void* process_transactions_thread(void *arg) {
     WorkerArgs *args = (WorkerArgs *)arg;
+    input_cursor cursor = {NULL, NULL};
     char buffer[256];
+    transaction txn;
+    money_t net_flow = 0;
+    delta_batch *batch = NULL;
+    audit_buffer audit;
 
-    while (1) {
-        pthread_mutex_lock(args->file_mutex);
-        if (!fgets(buffer, sizeof(buffer), args->input)) {
-            pthread_mutex_unlock(args->file_mutex);
-            break;
-        }
-        pthread_mutex_unlock(args->file_mutex);
+    // pinned before allocating, so the worker's buffers come from its own node
+    if (args->cpu >= 0) {
+        cpu_pin_thread(args->cpu);
+    }
+    audit_buffer_init(&audit, &audit_out);
 
-        command_line cmd = str_filler(buffer, " ");
-        if (cmd.num_token == 0) {
-            free_command_line(&cmd);
-            continue;
+    if (args->batched) {
+        batch = malloc(sizeof(delta_batch));
+        if (batch == NULL) {
+            perror("Delta batch allocation failed");
+            exit(1);
         }
+        delta_batch_init(batch);
+    }
 
-        char *type = cmd.command_list[0];
-        char log_entry[256];
-
-        if (strcmp(type, "D") == 0) { // Deposit
-            char *account_num = cmd.command_list[1];
-            char *password = cmd.command_list[2];
-            double amount = atof(cmd.command_list[3]);
+    if (args->dispatch != NULL) {
+        net_flow = dispatch_transactions(args);
+    } else if (args->pipeline != NULL) {
+        net_flow = execute_pipelined(args, batch, &audit);
+    } else do {
+        if (args->log != NULL) { // replay a compiled log, nothing left to parse
+            const txn_record *records;
+            size_t count;
 
-            for (int i = 0; i < args->num_accounts; i++) {
-                if (strcmp(args->accounts[i].account_number, account_num) == 0 &&
-                    strcmp(args->accounts[i].password, password) == 0) {
-                    pthread_mutex_lock(&args->account_mutexes[i]);
-                    args->accounts[i].balance += amount;
-                    args->accounts[i].transaction_tracter += amount;
-                    pthread_mutex_unlock(&args->account_mutexes[i]);
-                    break;
+            while ((count = txn_log_claim(args->log, &records)) > 0) {
+                for (size_t r = 0; r < count; r++) {
+                    STATS_START(start);
+                    txn_record_to_transaction(&records[r], &txn);
+                    STATS_COUNT(args->stats, lines);
+                    STATS_COMMAND(args->stats, &txn);
+                    net_flow += apply_transaction(args, batch, &audit, &txn);
+                    STATS_LATENCY(args->stats, txn.type, start);
                 }
             }
-        } else if (strcmp(type, "W") == 0) { // Withdraw
-            char *account_num = cmd.command_list[1];
-            char *password = cmd.command_list[2];
-            double amount = atof(cmd.command_list[3]);
-
-            for (int i = 0; i < args->num_accounts; i++) {
-                if (strcmp(args->accounts[i].account_number, account_num) == 0 &&
-                    strcmp(args->accounts[i].password, password) == 0) {
-                    pthread_mutex_lock(&args->account_mutexes[i]);
-                    args->accounts[i].balance -= amount;
-                    args->accounts[i].transaction_tracter += amount;
-                    pthread_mutex_unlock(&args->account_mutexes[i]);
-                    break;
+        } else {
+            while (next_line(args, &cursor, buffer, sizeof(buffer))) {
+                STATS_START(start);
+                STATS_COUNT(args->stats, lines);
+                if (transaction_parse(buffer, args->index, &txn)) {
+                    STATS_COMMAND(args->stats, &txn);
+                    net_flow += apply_transaction(args, batch, &audit, &txn);
+                    STATS_LATENCY(args->stats, txn.type, start);
                 }
             }
-        } else if (strcmp(type, "T") == 0) { // Transfer
-            char *src_account = cmd.command_list[1];
-            char *password = cmd.command_list[2];
-            char *dest_account = cmd.command_list[3];
-            double amount = atof(cmd.command_list[4]);
-
-            for (int i = 0; i < args->num_accounts; i++) {
-                if (strcmp(args->accounts[i].account_number, src_account) == 0 &&
-                    strcmp(args->accounts[i].password, password) == 0) {
-                    pthread_mutex_lock(&args->account_mutexes[i]);
-                    args->accounts[i].balance -= amount;
-                    args->accounts[i].transaction_tracter += amount;
-                    pthread_mutex_unlock(&args->account_mutexes[i]);
-
-                    for (int j = 0; j < args->num_accounts; j++) {
-                        if (strcmp(args->accounts[j].account_number, dest_account) == 0) {
-                            pthread_mutex_lock(&args->account_mutexes[j]);
-                            args->accounts[j].balance += amount;
-                            pthread_mutex_unlock(&args->account_mutexes[j]);
-                            break;
-                        }
-                    }
-                    break;
+        }
+
+        if (batch != NULL) { // a snapshot has to hold everything the segment applied
+            delta_batch_merge(batch, args->store, args->atomic_updates);
+        }
+        audit_flush(&audit); // and the ledger every check it logged
+    } while (next_segment(args));
+    audit_flush(&audit);
+
+    free(batch);
+    money_atomic_add(&money_flow, net_flow);
+    pthread_exit(NULL);
+}
+
+// A -q parser: reads and parses lines like a worker, but instead of applying
+// the transactions deals them out to the workers in batches, one worker after
+// the other. Lines that cannot change or read an account are dropped here.
+void* parse_stage_thread(void *arg) {
+    WorkerArgs *args = (WorkerArgs *)arg;
+    txn_pipeline *pipeline = args->pipeline;
+    input_cursor cursor = {NULL, NULL};
+    char buffer[256];
+    int executor = args->id % pipeline->num_executors; // parsers start out on different workers
+    txn_queue *queue = NULL;
+    txn_batch *batch = NULL;
+
+    if (args->cpu >= 0) {
+        cpu_pin_thread(args->cpu);
+    }
+
+    while (next_line(args, &cursor, buffer, sizeof(buffer))) {
+        STATS_COUNT(args->stats, lines);
+        if (batch == NULL) {
+            queue = txn_pipeline_queue(pipeline, args->id, executor);
+            batch = txn_queue_reserve(queue);
+        }
+
+        // parsed straight into the queue slot, only kept by counting it
+        transaction *txn = &batch->txns[batch->count];
+        if (!transaction_parse(buffer, args->index, txn)) {
+            continue;
+        }
+        STATS_COMMAND(args->stats, txn);
+        if (txn->src < 0 || (!txn->authorized && txn->type != 'C')) {
+            continue;
+        }
+        if (++batch->count == PIPELINE_BATCH) {
+            txn_queue_publish(queue);
+            batch = NULL;
+            executor = (executor + 1) % pipeline->num_executors;
+        }
+    }
+
+    if (batch != NULL && batch->count > 0) {
+        txn_queue_publish(queue);
+    }
+    for (int e = 0; e < pipeline->num_executors; e++) {
+        txn_queue_close(txn_pipeline_queue(pipeline, args->id, e));
+    }
+    pthread_exit(NULL);
+}
+
+// The -q worker loop: applies the batches the parsers queued for this worker
+// until every parser is done with the input. Returns the money that entered
+// the bank like apply_transaction.
+money_t execute_pipelined(WorkerArgs *args, delta_batch *batch, audit_buffer *audit) {
+    txn_pipeline *pipeline = args->pipeline;
+    money_t net_flow = 0;
+    int open = pipeline->num_parsers;
+
+    while (open > 0) {
+        int applied = 0;
+
+        open = 0;
+        for (int p = 0; p < pipeline->num_parsers; p++) {
+            txn_queue *queue = txn_pipeline_queue(pipeline, p, args->id);
+            txn_batch *txns;
+
+            while ((txns = txn_queue_peek(queue)) != NULL) {
+                for (int i = 0; i < txns->count; i++) {
+                    STATS_START(start);
+                    net_flow += apply_transaction(args, batch, audit, &txns->txns[i]);
+                    STATS_LATENCY(args->stats, txns->txns[i].type, start);
                 }
+                txn_queue_release(queue);
+                applied = 1;
             }
-        } else if (strcmp(type, "C") == 0) { // Check Balance
-            char *account_num = cmd.command_list[1];
-            for (int i = 0; i < args->num_accounts; i++) {
-                if (strcmp(args->accounts[i].account_number, account_num) == 0) {
-                    pthread_mutex_lock(&args->account_mutexes[i]);
-                    pthread_mutex_lock(&check_count_mutex);
-
-                    check_balance_count++;
-                    if (check_balance_count % CHECK_BALANCE_THRESHOLD == 0 && logged_checks < MAX_CHECK_LOGS) {
-                        logged_checks++;
-                        time_t now = time(NULL);
-                        snprintf(log_entry, sizeof(log_entry),
-                                 "Worker checked balance of Account %s. Balance is $%.2f. Check occured at %s",
-                                 account_num, args->accounts[i].balance, ctime(&now));
-                        log_to_pipe(log_entry);
-                    }
-
-                    pthread_mutex_unlock(&check_count_mutex);
-                    pthread_mutex_unlock(&args->account_mutexes[i]);
-                    break;
-                }
+            open += !txn_queue_drained(queue);
+        }
+        if (!applied && open > 0) { // the parsers are behind
+            sched_yield();
+        }
+    }
+
+    if (batch != NULL) {
+        delta_batch_merge(batch, args->store, args->atomic_updates);
+    }
+    return net_flow;
+}
+
+// The -d worker loop, a batch at a time: one worker reads it, everyone parses
+// a share, one groups it by partition, then everyone runs partitions until none
+// is left. Returns the money that entered the bank like apply_transaction.
+money_t dispatch_transactions(WorkerArgs *args) {
+    txn_dispatch *dispatch = args->dispatch;
+    money_t net_flow = 0;
+
+    while (1) {
+        if (pthread_barrier_wait(&dispatched.barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+            log_dispatched_checks(args);
+            read_batch(args);
+        }
+        pthread_barrier_wait(&dispatched.barrier);
+
+        int count = dispatched.count;
+        if (count == 0) {
+            break;
+        }
+        for (int i = count * args->id / num_workers; i < count * (args->id + 1) / num_workers; i++) {
+            parse_dispatched(args, i);
+        }
+
+        if (pthread_barrier_wait(&dispatched.barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+            sample_checks(dispatch);
+            txn_dispatch_prepare(dispatch, count);
+        }
+        pthread_barrier_wait(&dispatched.barrier);
+
+        int partition;
+        while ((partition = txn_dispatch_claim(dispatch, args->id)) >= 0) {
+            for (int e = dispatch->part_start[partition]; e < dispatch->part_start[partition + 1]; e++) {
+                // with -d the latency is the lock-free apply of one entry, a transfer's credit counts too
+                STATS_START(start);
+                net_flow += apply_entry(args, &dispatch->entries[e]);
+                STATS_LATENCY(args->stats, dispatch->txns[dispatch->entries[e].position].txn.type, start);
             }
         }
-        free_command_line(&cmd);
     }
+    return net_flow;
+}
 
-    pthread_exit(NULL);
+// Writes the checks the last batch logged, in file order, runs on one worker
+// while the others wait
+void log_dispatched_checks(WorkerArgs *args) {
+    for (int i = 0; i < dispatched.count; i++) {
+        const dispatched_txn *item = &args->dispatch->txns[i];
+
+        if (item->logged) {
+            audit_log(&dispatched.audit, AUDIT_CHECK_BALANCE, args->store->accounts[item->txn.src].account_number,
+                      item->seen, audit_time());
+        }
+    }
+    audit_flush(&dispatched.audit);
+}
+
+// Reads the next batch in file order, runs on one worker while the others wait
+void read_batch(WorkerArgs *args) {
+    int count = 0;
+
+    if (args->log != NULL) {
+        const txn_record *records;
+        size_t claimed;
+
+        // a single reader claims consecutive records
+        while (count < DISPATCH_BATCH && (claimed = txn_log_claim(args->log, &records)) > 0) {
+            if (count == 0) {
+                dispatched.records = records;
+            }
+            count += claimed;
+        }
+    } else {
+        while (count < DISPATCH_BATCH &&
+               next_line(args, &dispatched.cursor, dispatched.lines + (size_t)count * DISPATCH_LINE, DISPATCH_LINE)) {
+            count++;
+        }
+    }
+    dispatched.count = count;
+}
+
+void parse_dispatched(WorkerArgs *args, int position) {
+    dispatched_txn *item = &args->dispatch->txns[position];
+    transaction *txn = &item->txn;
+
+    STATS_COUNT(args->stats, lines);
+    if (args->log != NULL) {
+        txn_record_to_transaction(&dispatched.records[position], txn);
+    } else if (!transaction_parse(dispatched.lines + (size_t)position * DISPATCH_LINE, args->index, txn)) {
+        txn->src = -1;
+        item->logged = 0;
+        return;
+    }
+    STATS_COMMAND(args->stats, txn);
+    // a command with the wrong password changes nothing and is left out of the partitions
+    if (!txn->authorized && txn->type != 'C') {
+        txn->src = -1;
+    }
+    item->logged = 0;
 }
 
-void apply_rewards(Account *accounts, int num_accounts) {
-    for (int i = 0; i < num_accounts; i++) {
-        accounts[i].balance += accounts[i].transaction_tracter * accounts[i].reward_rate;
+// Picks the balance checks to log in file order, so the same checks are logged
+// on every run. Runs on one worker while the others wait.
+void sample_checks(txn_dispatch *dispatch) {
+    for (int i = 0; i < dispatched.count; i++) {
+        dispatched_txn *item = &dispatch->txns[i];
+
+        if (item->txn.type == 'C' && item->txn.src >= 0) {
+            int count = atomic_fetch_add(&check_balance_count, 1) + 1;
+            item->logged = count % CHECK_BALANCE_THRESHOLD == 0 && atomic_fetch_add(&logged_checks, 1) < MAX_CHECK_LOGS;
+        }
+    }
+}
+
+// Applies one side of a dispatched transaction without locks, only the worker
+// running the account's partition touches it during the batch. A transfer's
+// credit lands at the transfer's place among the destination's own changes,
+// which is all a later balance check on either account can observe.
+money_t apply_entry(WorkerArgs *args, const dispatch_entry *entry) {
+    dispatched_txn *item = &args->dispatch->txns[entry->position];
+    const transaction *txn = &item->txn;
+    account_state *src = &args->store->state[txn->src];
+
+    if (entry->credit) {
+        args->store->state[txn->dest].balance += txn->amount;
+        return 0;
+    }
+
+    switch (txn->type) {
+    case 'D':
+        src->balance += txn->amount;
+        src->transaction_tracter += txn->amount;
+        return txn->amount;
+    case 'W':
+        src->balance -= txn->amount;
+        src->transaction_tracter += txn->amount;
+        return -txn->amount;
+    case 'T':
+        src->balance -= txn->amount;
+        src->transaction_tracter += txn->amount;
+        if (txn->dest == txn->src) {
+            src->balance += txn->amount;
+        }
+        // money only leaves the bank when the destination is unknown
+        return txn->dest < 0 ? -txn->amount : 0;
+    case 'C':
+        if (item->logged) { // written to the ledger once the batch is done
+            item->seen = src->balance;
+        }
+        return 0;
+    }
+    return 0;
+}
+
+// Called by every worker once the current segment is used up. With -c the
+// workers wait for each other, one writes the snapshot and moves the readers
+// on to the next segment. Returns 1 while there is input left.
+int next_segment(WorkerArgs *args) {
+    if (checkpoint.path == NULL) {
+        return 0;
+    }
+
+    if (pthread_barrier_wait(&checkpoint.barrier) == PTHREAD_BARRIER_SERIAL_THREAD) {
+        write_checkpoint(args);
+    }
+    pthread_barrier_wait(&checkpoint.barrier);
+    return !checkpoint.done;
+}
+
+// Runs on one worker while the others wait at the barrier
+void write_checkpoint(WorkerArgs *args) {
+    snapshot_header info = {0};
+    size_t position;
+
+    if (args->log != NULL) {
+        position = args->log->end_record;
+        checkpoint.done = position >= args->log->num_records;
+        txn_log_segment(args->log, position, position + CHECKPOINT_RECORDS);
+    } else if (args->mapped != NULL) {
+        size_t end_chunk = args->mapped->end_chunk;
+        position = mapped_input_offset(args->mapped, end_chunk);
+        checkpoint.done = end_chunk >= args->mapped->num_chunks;
+        mapped_input_segment(args->mapped, end_chunk, end_chunk + CHECKPOINT_CHUNKS);
+    } else {
+        position = checkpoint.input_pos;
+        checkpoint.done = feof(args->input);
+        checkpoint.end = position + CHECKPOINT_BYTES;
+    }
+
+    info.position = position;
+    info.compiled = args->log != NULL;
+    info.check_balance_count = atomic_load(&check_balance_count);
+    info.logged_checks = atomic_load(&logged_checks);
+    info.input_size = checkpoint.input.st_size;
+    info.input_mtime = checkpoint.input.st_mtime;
+    info.ledger_records = checkpoint.ledger_base + audit_records_sent();
+    if (snapshot_write(checkpoint.path, args->store, &info) != 0) {
+        perror("Error writing snapshot");
     }
 }
 
-void log_interest_application(Account *accounts, int num_accounts) {
-    time_t now = time(NULL);
-    char log_entry[256];
-    
-    for (int i = 0; i < num_accounts; i++) {
-        snprintf(log_entry, sizeof(log_entry),
-                 "Applied interest to account %s. New Balance: $%.2f. Time of Update: %s",
-                 accounts[i].account_number, accounts[i].balance, ctime(&now));
-        log_to_pipe(log_entry);
+void apply_rewards(account_store *store) {
+    for (int i = 0; i < store->num_accounts; i++) {
+        store->state[i].balance += money_reward(store->state[i].transaction_tracter,
+                                                store->accounts[i].reward_rate);
     }
 }
 
-void write_output(Account *accounts, int num_accounts) {
-    FILE *output = fopen("out.txt", "w");
-    for (int i = 0; i < num_accounts; i++) {
-        fprintf(output, "%d balance:\t%.2f\n\n", i, accounts[i].balance);
+void log_interest_application(account_store *store) {
+    time_t now = audit_time();
+    audit_buffer audit;
+
+    audit_buffer_init(&audit, &audit_out);
+    for (int i = 0; i < store->num_accounts; i++) {
+        audit_log(&audit, AUDIT_INTEREST, store->accounts[i].account_number, store->state[i].balance, now);
     }
-    fclose(output);
+    audit_flush(&audit);
 }
 
-void log_to_pipe(const char *message) {
-    write(pipe_fd[1], message, strlen(message));
-}
\ No newline at end of file
+void write_output(account_store *store) {
+    if (output_write("out.txt", &store->state[0].balance, sizeof(account_state), store->num_accounts,
+                     num_workers) != 0) {
+        perror("Error writing out.txt");
+    }
+}
+
+time_t audit_time(void) {
+    return fixed_clock ? audit_clock : time(NULL);
+}
+
+money_t total_money(account_store *store) {
+    money_t total = 0;
+    for (int i = 0; i < store->num_accounts; i++) {
+        total += store->state[i].balance;
+    }
+    return total;
+}
@@ -0,0 +1,115 @@
+#define _GNU_SOURCE // F_SETPIPE_SZ
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/wait.h>
+#include "audit.h"
+
+#define PRODUCER_COUNTS 3
+#define EVENTS_PER_THREAD 1000000
+
+// Pushes a fixed number of audit events from 1, 4 and 10 bank threads to a
+// forked auditor, once over the pipe and once over the shared-memory ring,
+// and reports end-to-end events per second (until the auditor has read the
+// last one). The auditor only counts records so the transport is what is
+// measured, formatting the ledger costs the same in both modes.
+
+typedef struct {
+    audit_channel *channel;
+} BenchArgs;
+
+static double elapsed_sec(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static void* produce(void *arg)
+{
+    BenchArgs *args = (BenchArgs *)arg;
+    audit_buffer audit;
+
+    audit_buffer_init(&audit, args->channel);
+    for (int n = 0; n < EVENTS_PER_THREAD; n++) {
+        audit_log(&audit, AUDIT_CHECK_BALANCE, "0123456789012345", money_from_cents(n), 0);
+    }
+    audit_flush(&audit);
+    return NULL;
+}
+
+// forks a counting auditor, returns events per second or -1 if records went missing
+static double run(int shared, int num_threads)
+{
+    static audit_record records[4096];
+    audit_channel channel = {-1, NULL};
+    int pipe_fd[2];
+
+    if (shared) {
+        if (audit_ring_create(&channel) != 0) {
+            perror("Audit ring creation failed");
+            exit(1);
+        }
+    } else if (pipe(pipe_fd) == -1) {
+        perror("Pipe creation failed");
+        exit(1);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        audit_channel in = channel;
+        long long total = 0;
+        size_t count;
+
+        if (!shared) {
+            close(pipe_fd[1]);
+            in.fd = pipe_fd[0];
+        }
+        while ((count = audit_channel_read(&in, records, 4096)) > 0) {
+            total += count;
+        }
+        _exit(total == (long long)num_threads * EVENTS_PER_THREAD ? 0 : 1); // no flush of the parent's stdio
+    }
+
+    if (!shared) {
+        close(pipe_fd[0]);
+        fcntl(pipe_fd[1], F_SETPIPE_SZ, AUDIT_PIPE_SIZE);
+        channel.fd = pipe_fd[1];
+    }
+
+    pthread_t threads[10];
+    BenchArgs args = {&channel};
+    for (int t = 0; t < num_threads; t++) {
+        pthread_create(&threads[t], NULL, produce, &args);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    audit_channel_close(&channel);
+
+    int status;
+    waitpid(pid, &status, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    return (double)num_threads * EVENTS_PER_THREAD / elapsed_sec(start, end);
+}
+
+int main(void)
+{
+    int thread_counts[PRODUCER_COUNTS] = {1, 4, 10};
+
+    printf("threads\tpipe events/s\tshm ring events/s\n");
+    for (int c = 0; c < PRODUCER_COUNTS; c++) {
+        double pipe_rate = run(0, thread_counts[c]);
+        double ring_rate = run(1, thread_counts[c]);
+        printf("%d\t%.0f\t%.0f\n", thread_counts[c], pipe_rate, ring_rate);
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "account.h"
+#include "account_header.h"
+
+#define NUM_ACCOUNTS 1000000
+
+// Writes a 1M-account header to a temporary file and times how long it takes
+// to load it with the fscanf loop the banks used to run and with
+// account_header at 1, 4 and 10 threads, checking every run loads the same
+// accounts. Some passwords are "index" to check the threads' split. This is the startup cost paid before any worker starts.
+
+static double elapsed_ms(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+static void write_header(FILE *out)
+{
+    srand(415);
+    fprintf(out, "%d\n", NUM_ACCOUNTS);
+    for (int i = 0; i < NUM_ACCOUNTS; i++) {
+        if (i % 2 == 0) {
+            // a password of "index" looks like a block start to a thread resyncing
+            // mid-header, before a balance without cents it parses as one
+            fprintf(out, i % 4 == 0 ? "index %d\n%08d%08d\nindex\n%d\n0.%03d\n" :
+                    "index %d\n%08d%08d\nindex\n%d.00\n0.%03d\n", i, rand() % 100000000,
+                    rand() % 100000000, rand() % 5000000, rand() % 100);
+            continue;
+        }
+        fprintf(out, "index %d\n%08d%08d\n%08x\n%d.%02d\n0.%03d\n", i, rand() % 100000000,
+                rand() % 100000000, (unsigned)rand(), rand() % 5000000, rand() % 100, rand() % 100);
+    }
+    fprintf(out, "0000000000000000 pass D 0000000000000001 1.00\n");
+}
+
+static void load_fscanf(const char *path, Account *accounts, money_t *balances)
+{
+    FILE *input = fopen(path, "r");
+    int num_accounts;
+    char field[64];
+
+    fscanf(input, "%d\n", &num_accounts);
+    for (int i = 0; i < num_accounts; i++) {
+        fscanf(input, "index %*d\n");
+        fscanf(input, "%s\n", accounts[i].account_number);
+        fscanf(input, "%s\n", accounts[i].password);
+        fscanf(input, "%63s\n", field);
+        balances[i] = money_parse(field);
+        fscanf(input, "%63s\n", field);
+        accounts[i].reward_rate = rate_parse(field);
+    }
+    fclose(input);
+}
+
+static int load_header(const char *path, Account *accounts, money_t *balances, int num_threads)
+{
+    account_header header;
+
+    if (account_header_open(&header, path) != 0) {
+        return -1;
+    }
+    int status = account_header_parse(&header, accounts, balances, sizeof(money_t), num_threads);
+    account_header_close(&header);
+    return status;
+}
+
+static int same_accounts(Account *a, money_t *a_balances, Account *b, money_t *b_balances)
+{
+    for (int i = 0; i < NUM_ACCOUNTS; i++) {
+        if (strcmp(a[i].account_number, b[i].account_number) != 0 ||
+            strcmp(a[i].password, b[i].password) != 0 ||
+            a[i].reward_rate != b[i].reward_rate || a_balances[i] != b_balances[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void)
+{
+    char path[] = "/tmp/bench_header_XXXXXX";
+    int fd = mkstemp(path);
+    FILE *out = fd == -1 ? NULL : fdopen(fd, "w");
+    Account *expected = calloc(NUM_ACCOUNTS, sizeof(Account));
+    Account *accounts = calloc(NUM_ACCOUNTS, sizeof(Account));
+    money_t *expected_balances = calloc(NUM_ACCOUNTS, sizeof(money_t));
+    money_t *balances = calloc(NUM_ACCOUNTS, sizeof(money_t));
+    struct timespec start, end;
+
+    if (out == NULL || expected == NULL || accounts == NULL || expected_balances == NULL || balances == NULL) {
+        perror("Bench setup failed");
+        return 1;
+    }
+    write_header(out);
+    fclose(out);
+
+    printf("%d accounts\n", NUM_ACCOUNTS);
+    printf("loader\t\tms\n");
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    load_fscanf(path, expected, expected_balances);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("fscanf loop\t%.1f\n", elapsed_ms(start, end));
+
+    int thread_counts[] = {1, 4, 10};
+    for (int c = 0; c < 3; c++) {
+        memset(accounts, 0, sizeof(Account) * NUM_ACCOUNTS);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int status = load_header(path, accounts, balances, thread_counts[c]);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (status != 0 || !same_accounts(expected, expected_balances, accounts, balances)) {
+            printf("header %d threads loaded different accounts\n", thread_counts[c]);
+            unlink(path);
+            return 1;
+        }
+        printf("header %d thr\t%.1f\n", thread_counts[c], elapsed_ms(start, end));
+    }
+
+    unlink(path);
+    free(balances);
+    free(expected_balances);
+    free(accounts);
+    free(expected);
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "account.h"
+#include "account_index.h"
+
+#define LOOKUPS 1000000
+#define LINEAR_BUDGET 20000000   // account comparisons spent on the scan per size
+
+// Times account lookups through the hash index against the old strcmp scan
+// for growing account counts. The index should stay flat while the scan grows
+// linearly with the number of accounts.
+
+static double elapsed_ns(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+static int linear_find(Account *accounts, int num_accounts, const char *account_number)
+{
+    for (int i = 0; i < num_accounts; i++) {
+        if (strcmp(accounts[i].account_number, account_number) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int main(void)
+{
+    int sizes[] = {1000, 10000, 100000, 1000000};
+    int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    volatile long sink = 0;
+
+    srand(415);
+    printf("accounts\tindex ns/lookup\tscan ns/lookup\n");
+
+    for (int s = 0; s < num_sizes; s++) {
+        int num_accounts = sizes[s];
+        Account *accounts = malloc(sizeof(Account) * num_accounts);
+        int *probes = malloc(sizeof(int) * LOOKUPS);
+        struct timespec start, end;
+        account_index index;
+
+        for (int i = 0; i < num_accounts; i++) {
+            snprintf(accounts[i].account_number, sizeof(accounts[i].account_number),
+                     "%08u%08u", (unsigned)rand() % 100000000u, (unsigned)i % 100000000u);
+        }
+        for (int i = 0; i < LOOKUPS; i++) {
+            probes[i] = rand() % num_accounts;
+        }
+
+        if (account_index_build(&index, accounts, num_accounts) != 0) {
+            perror("Account index allocation failed");
+            return 1;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < LOOKUPS; i++) {
+            sink += account_index_find(&index, accounts[probes[i]].account_number);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double index_ns = elapsed_ns(start, end) / LOOKUPS;
+
+        int linear_lookups = LINEAR_BUDGET / num_accounts;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < linear_lookups; i++) {
+            sink += linear_find(accounts, num_accounts, accounts[probes[i]].account_number);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double scan_ns = elapsed_ns(start, end) / linear_lookups;
+
+        printf("%d\t\t%.1f\t\t%.1f\n", num_accounts, index_ns, scan_ns);
+
+        account_index_free(&index);
+        free(probes);
+        free(accounts);
+    }
+
+    return sink == 0;
+}
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include "account_store.h"
+
+#define HOT_ACCOUNTS 64
+#define UPDATES_PER_THREAD 2000000
+#define MAX_THREADS 16
+
+// Deposits into a small set of hot accounts, each thread owning the accounts
+// whose index is congruent to its id, so threads never touch the same account
+// but do touch neighbouring ones. With the old packed Account array and the
+// separate account_mutexes array neighbouring locks and balances share cache
+// lines, with account_state every account has a line to itself.
+
+// the layout part2 used before the store split hot and cold data
+typedef struct {
+    char account_number[17];
+    char password[20];
+    money_t balance;
+    rate_t reward_rate;
+    money_t transaction_tracter;
+    char out_file[64];
+    pthread_mutex_t ac_lock;
+} packed_account;
+
+typedef struct {
+    int id;
+    int num_threads;
+    packed_account *packed;
+    pthread_mutex_t *packed_locks;
+    account_store *store;
+} BenchArgs;
+
+static double elapsed_sec(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static void* deposit_packed(void *arg)
+{
+    BenchArgs *args = (BenchArgs *)arg;
+    int owned = 0;
+
+    for (int n = 0; n < UPDATES_PER_THREAD; n++) {
+        int i = args->id + owned * args->num_threads;
+        owned = (i + args->num_threads < HOT_ACCOUNTS) ? owned + 1 : 0;
+
+        pthread_mutex_lock(&args->packed_locks[i]);
+        args->packed[i].balance += 1;
+        args->packed[i].transaction_tracter += 1;
+        pthread_mutex_unlock(&args->packed_locks[i]);
+    }
+    return NULL;
+}
+
+static void* deposit_store(void *arg)
+{
+    BenchArgs *args = (BenchArgs *)arg;
+    int owned = 0;
+
+    for (int n = 0; n < UPDATES_PER_THREAD; n++) {
+        int i = args->id + owned * args->num_threads;
+        owned = (i + args->num_threads < HOT_ACCOUNTS) ? owned + 1 : 0;
+
+        account_state *state = &args->store->state[i];
+        pthread_mutex_lock(&state->lock);
+        state->balance += 1;
+        state->transaction_tracter += 1;
+        pthread_mutex_unlock(&state->lock);
+    }
+    return NULL;
+}
+
+static double run(void *(*deposit)(void *), int num_threads, packed_account *packed,
+                  pthread_mutex_t *packed_locks, account_store *store)
+{
+    pthread_t threads[MAX_THREADS];
+    BenchArgs args[MAX_THREADS];
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int t = 0; t < num_threads; t++) {
+        args[t] = (BenchArgs){t, num_threads, packed, packed_locks, store};
+        pthread_create(&threads[t], NULL, deposit, &args[t]);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (double)UPDATES_PER_THREAD * num_threads / elapsed_sec(start, end);
+}
+
+int main(void)
+{
+    int thread_counts[] = {1, 2, 4, 8, 10, 16};
+    int num_counts = sizeof(thread_counts) / sizeof(thread_counts[0]);
+    packed_account *packed = calloc(HOT_ACCOUNTS, sizeof(packed_account));
+    pthread_mutex_t *packed_locks = malloc(sizeof(pthread_mutex_t) * HOT_ACCOUNTS);
+    account_store store;
+
+    if (packed == NULL || packed_locks == NULL || account_store_init(&store, HOT_ACCOUNTS) != 0) {
+        perror("Allocation failed");
+        return 1;
+    }
+    for (int i = 0; i < HOT_ACCOUNTS; i++) {
+        pthread_mutex_init(&packed_locks[i], NULL);
+    }
+
+    printf("threads\tpacked updates/s\tstore updates/s\n");
+    for (int c = 0; c < num_counts; c++) {
+        double packed_rate = run(deposit_packed, thread_counts[c], packed, packed_locks, &store);
+        double store_rate = run(deposit_store, thread_counts[c], packed, packed_locks, &store);
+        printf("%d\t%.0f\t\t%.0f\n", thread_counts[c], packed_rate, store_rate);
+    }
+
+    for (int i = 0; i < HOT_ACCOUNTS; i++) {
+        pthread_mutex_destroy(&packed_locks[i]);
+    }
+    account_store_free(&store);
+    free(packed_locks);
+    free(packed);
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "money.h"
+#include "output_writer.h"
+
+#define NUM_ACCOUNTS 1000000
+
+// Times writing a 1M-account out.txt with the fprintf loop the banks used to
+// run and with output_write at 1, 4 and 10 threads, checking every file is
+// byte-identical to the fprintf one. Balances mix whole, negative and
+// sub-cent values so both the formatting and its rounding are exercised.
+
+static double elapsed_ms(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+static void write_fprintf(const char *path, money_t *balances)
+{
+    FILE *output = fopen(path, "w");
+    for (int i = 0; i < NUM_ACCOUNTS; i++) {
+        fprintf(output, "%d balance:\t" MONEY_FMT "\n\n", i, MONEY_ARGS(balances[i]));
+    }
+    fclose(output);
+}
+
+static int same_file(const char *a, const char *b)
+{
+    FILE *fa = fopen(a, "r"), *fb = fopen(b, "r");
+    char ba[65536], bb[65536];
+    size_t na, nb;
+    int same = fa != NULL && fb != NULL;
+
+    while (same) {
+        na = fread(ba, 1, sizeof(ba), fa);
+        nb = fread(bb, 1, sizeof(bb), fb);
+        same = na == nb && memcmp(ba, bb, na) == 0;
+        if (na == 0) {
+            break;
+        }
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+int main(void)
+{
+    char expected[] = "/tmp/bench_output_XXXXXX", actual[] = "/tmp/bench_output_XXXXXX";
+    int fd_expected = mkstemp(expected), fd_actual = mkstemp(actual);
+    money_t *balances = malloc(NUM_ACCOUNTS * sizeof(money_t));
+    struct timespec start, end;
+
+    if (fd_expected == -1 || fd_actual == -1 || balances == NULL) {
+        perror("Bench setup failed");
+        return 1;
+    }
+    close(fd_expected);
+    close(fd_actual);
+
+    srand(417);
+    for (int i = 0; i < NUM_ACCOUNTS; i++) {
+        money_t balance = money_from_cents((int64_t)(rand() % 500000000) - 1000);
+#ifndef FIXED_POINT
+        // rewards leave doubles between cents
+        balance += (rand() % 1000) / 100000.0;
+#endif
+        balances[i] = balance;
+    }
+
+    printf("%d accounts\n", NUM_ACCOUNTS);
+    printf("writer\t\tms\n");
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    write_fprintf(expected, balances);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("fprintf loop\t%.1f\n", elapsed_ms(start, end));
+
+    int thread_counts[] = {1, 4, 10};
+    for (int c = 0; c < 3; c++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int status = output_write(actual, balances, sizeof(money_t), NUM_ACCOUNTS, thread_counts[c]);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (status != 0 || !same_file(expected, actual)) {
+            printf("output_write %d threads wrote a different file\n", thread_counts[c]);
+            unlink(expected);
+            unlink(actual);
+            return 1;
+        }
+        printf("writer %d thr\t%.1f\n", thread_counts[c], elapsed_ms(start, end));
+    }
+
+    unlink(expected);
+    unlink(actual);
+    free(balances);
+    return 0;
+}
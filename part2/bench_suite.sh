@@ -0,0 +1,122 @@
+#!/bin/bash
+
+# Throughput benchmark across the bank variants. Generates inputs with
+# ./generate for every size and command mix, builds every variant once and runs
+# it over every input and worker count (-w) with -P, which prints per-phase
+# times and peak RSS. Results
+# are appended to a CSV, one row per run, tagged with the build so runs of
+# different commits can be compared.
+#
+#   ./bench_suite.sh                          # or make suite
+#   SIZES="1000000:20000000" WORKERS="4 16" REPEAT=3 ./bench_suite.sh
+#   VARIANTS=part2 PART2_FLAGS="-m -a" FIXED_POINT=1 ./bench_suite.sh
+#
+# Settings, all optional:
+#   VARIANTS     part1 part2 Part3
+#   SIZES        accounts:transactions pairs
+#   MIXES        D:W:T:C weights passed to ./generate -x
+#   WORKERS      worker counts for part2 and Part3, part1 always runs with 1
+#   ZIPF BAD SEED  account skew, wrong-password fraction and seed for ./generate
+#   REPEAT       runs per combination
+#   PART1_FLAGS PART2_FLAGS PART3_FLAGS  extra options for each variant, -p to pin threads
+#   FIXED_POINT  set to build with integer cents
+#   RESULTS      CSV file, bench_results.csv in this directory by default
+#   WORK_DIR     scratch space for inputs, builds and out.txt files
+
+cd "$(dirname "$0")" || exit 1
+ROOT=$(cd .. && pwd)
+
+VARIANTS=${VARIANTS:-part1 part2 Part3}
+SIZES=${SIZES:-10000:200000 100000:2000000}
+MIXES=${MIXES:-30:25:25:20 10:10:70:10 5:5:10:80}
+WORKERS=${WORKERS:-1 4 10}
+ZIPF=${ZIPF:-1.0}
+BAD=${BAD:-0.01}
+SEED=${SEED:-1}
+REPEAT=${REPEAT:-1}
+RESULTS=${RESULTS:-$PWD/bench_results.csv}
+WORK_DIR=${WORK_DIR:-${TMPDIR:-/tmp}/bank_bench}
+BUILD=${BUILD:-$(git rev-parse --short HEAD 2>/dev/null || echo unknown)$(git diff --quiet HEAD 2>/dev/null || echo -dirty)}
+
+mkdir -p "$WORK_DIR/inputs" "$WORK_DIR/builds" "$WORK_DIR/run" || exit 1
+make -s generate || exit 1
+
+# builds one variant into its own directory, echoes the binary
+build_variant() {
+  local variant=$1
+  local dir="$WORK_DIR/builds/$variant${FIXED_POINT:+-fixed}"
+  local binary=bank
+
+  [ "$variant" = part1 ] && binary=part1
+  rm -rf "$dir" && mkdir -p "$dir" || return 1
+  cp "$ROOT/$variant"/*.c "$ROOT/$variant"/*.h "$ROOT/$variant/Makefile" "$dir" || return 1
+  make -s -C "$dir" "$binary" ${FIXED_POINT:+FIXED_POINT=1} >&2 || return 1
+  echo "$dir/$binary"
+}
+
+variant_flags() {
+  case $1 in
+  part1) echo "$PART1_FLAGS" ;;
+  part2) echo "$PART2_FLAGS" ;;
+  Part3) echo "$PART3_FLAGS" ;;
+  esac
+}
+
+# the value of key=... in a -P phases line
+phase_value() {
+  sed -n "s/.* $2=\([0-9.-]*\).*/\1/p" <<< "$1"
+}
+
+if [ ! -s "$RESULTS" ]; then
+  echo "build,variant,flags,workers,accounts,transactions,mix,zipf,bad,run,status,wall_ms,txn_per_s,peak_rss_kb,header_ms,process_ms,rewards_ms,output_ms" > "$RESULTS"
+fi
+printf "%-7s %-8s %3s %9s %10s %-12s %10s %12s %10s\n" variant flags w accounts txns mix wall_ms txn/s rss_kb
+
+for variant in $VARIANTS; do
+  if [ ! -d "$ROOT/$variant" ]; then
+    echo "Unknown variant $variant" >&2
+    exit 1
+  fi
+  worker_counts=$WORKERS
+  [ "$variant" = part1 ] && worker_counts=1
+  flags=$(variant_flags "$variant")
+  binary=$(build_variant "$variant") || { echo "Building $variant failed" >&2; exit 1; }
+
+  for workers in $worker_counts; do
+    run_flags=$flags
+    [ "$variant" != part1 ] && run_flags="-w $workers $flags"
+
+    for size in $SIZES; do
+      accounts=${size%%:*}
+      transactions=${size##*:}
+      for mix in $MIXES; do
+        input="$WORK_DIR/inputs/a${accounts}_n${transactions}_x${mix//:/-}_z${ZIPF}_p${BAD}_s${SEED}.txt"
+        if [ ! -s "$input" ]; then
+          ./generate -a "$accounts" -n "$transactions" -x "$mix" -z "$ZIPF" -p "$BAD" -s "$SEED" -o "$input" || exit 1
+        fi
+
+        for ((run=1; run<=REPEAT; run++)); do
+          # out.txt and ledger.txt land in the run directory, not in the tree
+          START_NS=$(date +%s%N)
+          (cd "$WORK_DIR/run" && "$binary" -P $run_flags "$input" > /dev/null 2> stderr.txt)
+          status=$?
+          END_NS=$(date +%s%N)
+
+          phases=$(grep '^phases ' "$WORK_DIR/run/stderr.txt" | tail -n 1)
+          wall_ms=$(( (END_NS - START_NS) / 1000000 ))
+          txn_per_s=$(( transactions * 1000 / (wall_ms > 0 ? wall_ms : 1) ))
+          if [ $status -ne 0 ]; then
+            echo "$variant $flags exited with status $status on $input" >&2
+            txn_per_s=
+          fi
+          rss=$(phase_value "$phases" peak_rss_kb)
+
+          echo "$BUILD,$variant,\"$flags\",$workers,$accounts,$transactions,$mix,$ZIPF,$BAD,$run,$status,$wall_ms,$txn_per_s,$rss,$(phase_value "$phases" header_ms),$(phase_value "$phases" process_ms),$(phase_value "$phases" rewards_ms),$(phase_value "$phases" output_ms)" >> "$RESULTS"
+          printf "%-7s %-8s %3s %9s %10s %-12s %10s %12s %10s\n" "$variant" "${flags:--}" "$workers" "$accounts" "$transactions" "$mix" "$wall_ms" "$txn_per_s" "${rss:--}"
+        done
+      done
+    done
+  done
+done
+
+echo "Results appended to $RESULTS"
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "string_parser.h"
+
+#define LINES_PER_THREAD 500000
+#define NUM_THREADS 10
+
+// Compares lines/sec of str_filler + free_command_line against the in-place
+// str_tokenize, single threaded and with NUM_THREADS threads tokenizing at the
+// same time the way the bank workers do.
+
+static const char *sample_lines[] = {
+    "T 3491588839892013 a2rogubb 6847226299857821 1520.75\n",
+    "D 4659001911688512 qh524yng 310.02\n",
+    "W 0793710490620664 k1o9x3rt 47.50\n",
+    "C 1093278990669429 pp0d8wq2\n",
+};
+
+typedef struct {
+    int use_view;
+    long sink;
+} BenchArgs;
+
+static double elapsed_sec(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static void* tokenize_lines(void *arg)
+{
+    BenchArgs *args = (BenchArgs *)arg;
+    int num_samples = sizeof(sample_lines) / sizeof(sample_lines[0]);
+    char buffer[256];
+
+    for (int i = 0; i < LINES_PER_THREAD; i++) {
+        strcpy(buffer, sample_lines[i % num_samples]);
+
+        if (args->use_view) {
+            token_view cmd;
+            str_tokenize(buffer, " ", &cmd);
+            args->sink += cmd.num_token + cmd.tokens[0][0];
+        } else {
+            command_line cmd = str_filler(buffer, " ");
+            args->sink += cmd.num_token + cmd.command_list[0][0];
+            free_command_line(&cmd);
+        }
+    }
+
+    return NULL;
+}
+
+static double run(int use_view, int num_threads)
+{
+    pthread_t threads[NUM_THREADS];
+    BenchArgs args[NUM_THREADS];
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < num_threads; i++) {
+        args[i].use_view = use_view;
+        args[i].sink = 0;
+        pthread_create(&threads[i], NULL, tokenize_lines, &args[i]);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (double)LINES_PER_THREAD * num_threads / elapsed_sec(start, end);
+}
+
+int main(void)
+{
+    int thread_counts[] = {1, NUM_THREADS};
+
+    printf("threads\tstr_filler lines/s\tstr_tokenize lines/s\n");
+    for (int i = 0; i < 2; i++) {
+        double old_rate = run(0, thread_counts[i]);
+        double new_rate = run(1, thread_counts[i]);
+        printf("%d\t%.0f\t\t%.0f\n", thread_counts[i], old_rate, new_rate);
+    }
+
+    return 0;
+}
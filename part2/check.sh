@@ -0,0 +1,101 @@
+#!/bin/bash
+
+# Determinism check for bank -D. Generates inputs with ./generate, then runs
+# -D over each of them with every worker count (-w), input mode (fgets, -m and
+# a compiled log with -b) and audit channel (the pipe and -s). Fails unless
+# out.txt and ledger.txt are byte-identical across all of those runs and out.txt
+# matches what part1 writes for the same input.
+#
+#   ./check.sh                                # or make check
+#   SIZES="1000000:20000000" WORKERS="1 16" ./check.sh
+#   FIXED_POINT=1 ./check.sh
+#
+# Settings, all optional:
+#   SIZES        accounts:transactions pairs, one generated input each
+#   MIX          D:W:T:C weights passed to ./generate -x
+#   WORKERS      worker counts for part2
+#   ZIPF BAD SEED  account skew, wrong-password fraction and seed for ./generate
+#   FIXED_POINT  set to build with integer cents
+#   WORK_DIR     scratch space for inputs, builds and out.txt files
+
+cd "$(dirname "$0")" || exit 1
+ROOT=$(cd .. && pwd)
+
+SIZES=${SIZES:-10000:200000 100000:2000000}
+MIX=${MIX:-30:25:25:20}
+WORKERS=${WORKERS:-1 3 10 16}
+ZIPF=${ZIPF:-1.0}
+BAD=${BAD:-0.01}
+SEED=${SEED:-1}
+WORK_DIR=${WORK_DIR:-${TMPDIR:-/tmp}/bank_check}
+
+mkdir -p "$WORK_DIR/inputs" "$WORK_DIR/builds" "$WORK_DIR/run" || exit 1
+make -s generate || exit 1
+
+# builds one variant's targets into its own directory
+build_variant() {
+  local variant=$1
+  local dir="$WORK_DIR/builds/$variant${FIXED_POINT:+-fixed}"
+  shift
+
+  rm -rf "$dir" && mkdir -p "$dir" || return 1
+  cp "$ROOT/$variant"/*.c "$ROOT/$variant"/*.h "$ROOT/$variant/Makefile" "$dir" || return 1
+  make -s -C "$dir" "$@" ${FIXED_POINT:+FIXED_POINT=1} >&2
+}
+
+build_variant part1 part1 || { echo "Building part1 failed" >&2; exit 1; }
+build_variant part2 bank compile || { echo "Building part2 failed" >&2; exit 1; }
+PART1="$WORK_DIR/builds/part1${FIXED_POINT:+-fixed}/part1"
+BANK="$WORK_DIR/builds/part2${FIXED_POINT:+-fixed}/bank"
+COMPILE="$WORK_DIR/builds/part2${FIXED_POINT:+-fixed}/compile"
+
+failed=0
+for size in $SIZES; do
+  accounts=${size%%:*}
+  transactions=${size##*:}
+  input="$WORK_DIR/inputs/a${accounts}_n${transactions}_x${MIX//:/-}_z${ZIPF}_p${BAD}_s${SEED}.txt"
+  if [ ! -s "$input" ]; then
+    ./generate -a "$accounts" -n "$transactions" -x "$MIX" -z "$ZIPF" -p "$BAD" -s "$SEED" -o "$input" || exit 1
+  fi
+  "$COMPILE" "$input" "$WORK_DIR/run/input.bin" > /dev/null || exit 1
+
+  # out.txt and ledger.txt land in the run directory, not in the tree
+  (cd "$WORK_DIR/run" && "$PART1" "$input" && mv out.txt part1_out.txt) || exit 1
+  reference=
+
+  for workers in $WORKERS; do
+    for mode in "" "-m" "-b input.bin"; do
+      for channel in "" "-s"; do
+        flags="-D -w $workers $mode $channel"
+        if ! (cd "$WORK_DIR/run" && "$BANK" $flags "$input"); then
+          echo "bank $flags exited with an error on $input" >&2
+          failed=1
+          continue
+        fi
+
+        if [ -z "$reference" ]; then
+          reference=$flags
+          cp "$WORK_DIR/run/out.txt" "$WORK_DIR/run/first_out.txt"
+          cp "$WORK_DIR/run/ledger.txt" "$WORK_DIR/run/first_ledger.txt"
+          if ! cmp -s "$WORK_DIR/run/out.txt" "$WORK_DIR/run/part1_out.txt"; then
+            echo "bank $flags wrote a different out.txt than part1 on $input" >&2
+            failed=1
+          fi
+        elif ! cmp -s "$WORK_DIR/run/out.txt" "$WORK_DIR/run/first_out.txt"; then
+          echo "bank $flags wrote a different out.txt than bank $reference on $input" >&2
+          failed=1
+        elif ! cmp -s "$WORK_DIR/run/ledger.txt" "$WORK_DIR/run/first_ledger.txt"; then
+          echo "bank $flags wrote a different ledger.txt than bank $reference on $input" >&2
+          failed=1
+        fi
+      done
+    done
+  done
+  echo "$accounts accounts, $transactions transactions: out.txt $(md5sum < "$WORK_DIR/run/first_out.txt" | cut -c1-32), ledger.txt $(md5sum < "$WORK_DIR/run/first_ledger.txt" | cut -c1-32)"
+done
+
+if [ $failed -ne 0 ]; then
+  echo "Deterministic replay check failed"
+  exit 1
+fi
+echo "Every -D run matched across worker counts, input modes and audit channels"
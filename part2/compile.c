@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "account.h"
+#include "account_header.h"
+#include "account_index.h"
+#include "transaction.h"
+#include "txn_log.h"
+
+#define HEADER_THREADS 8
+
+// Converts a bank input file into the fixed-width binary log replayed by
+// ./bank -b, so repeated runs over the same day skip text parsing. Account
+// numbers are resolved to indices and passwords are checked here, the log is
+// only valid together with the account header it was compiled from.
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <input_file> <compiled_log>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *input = fopen(argv[1], "r");
+    if (!input) {
+        perror("Error opening file");
+        return 1;
+    }
+    FILE *output = fopen(argv[2], "wb");
+    if (!output) {
+        perror("Error opening compiled log");
+        return 1;
+    }
+
+    account_header header;
+    if (account_header_open(&header, argv[1]) != 0) {
+        fprintf(stderr, "Error reading account header of %s\n", argv[1]);
+        return 1;
+    }
+    int num_accounts = header.num_accounts;
+
+    // balances are not part of the log, they are parsed into a scratch array
+    Account *accounts = malloc(sizeof(Account) * (num_accounts > 0 ? num_accounts : 1));
+    money_t *balances = malloc(sizeof(money_t) * (num_accounts > 0 ? num_accounts : 1));
+    if (accounts == NULL || balances == NULL) {
+        perror("Account allocation failed");
+        return 1;
+    }
+    if (account_header_parse(&header, accounts, balances, sizeof(money_t), HEADER_THREADS) != 0) {
+        fprintf(stderr, "Malformed account header in %s\n", argv[1]);
+        return 1;
+    }
+    fseek(input, header.body, SEEK_SET);
+    account_header_close(&header);
+    free(balances);
+
+    account_index index;
+    if (account_index_build(&index, accounts, num_accounts) != 0) {
+        perror("Account index allocation failed");
+        return 1;
+    }
+
+    char buffer[256];
+    transaction txn;
+    unsigned long long num_records = 0;
+
+    if (txn_log_begin(output, num_accounts) != 0) {
+        perror("Error writing compiled log");
+        return 1;
+    }
+    while (fgets(buffer, sizeof(buffer), input)) {
+        if (!transaction_parse(buffer, &index, &txn)) {
+            continue;
+        }
+        if (txn_log_append(output, &txn) != 0) {
+            perror("Error writing compiled log");
+            return 1;
+        }
+        num_records++;
+    }
+    if (txn_log_finish(output, num_accounts, num_records) != 0) {
+        perror("Error writing compiled log");
+        return 1;
+    }
+
+    printf("Compiled %llu transactions for %d accounts into %s\n", num_records, num_accounts, argv[2]);
+
+    account_index_free(&index);
+    free(accounts);
+    fclose(input);
+    fclose(output);
+    return 0;
+}
@@ -0,0 +1,136 @@
+#define _GNU_SOURCE // sched_getaffinity, pthread_setaffinity_np
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "cpu_topology.h"
+
+typedef struct
+{
+    int cpu;
+    int node;
+    int sibling;                // 1 unless cpu is the lowest numbered thread of its core
+}cpu_place;
+
+// The node directory sysfs links under the CPU, 0 if there is none
+static int cpu_node(int cpu)
+{
+    char path[64];
+    struct dirent* entry;
+    int node = 0;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR* dir = opendir(path);
+    if (dir == NULL) {
+        return 0;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+// Whether a lower numbered hardware thread shares cpu's core, the siblings
+// list ("0,32" or "0-1") starts with the lowest
+static int is_sibling(int cpu)
+{
+    char path[96];
+    int first = cpu;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return 0;
+    }
+    if (fscanf(file, "%d", &first) != 1) {
+        first = cpu;
+    }
+    fclose(file);
+    return first != cpu;
+}
+
+static int compare_places(const void* a, const void* b)
+{
+    const cpu_place* x = (const cpu_place*)a;
+    const cpu_place* y = (const cpu_place*)b;
+
+    if (x->sibling != y->sibling) {
+        return x->sibling - y->sibling;
+    }
+    if (x->node != y->node) {
+        return x->node - y->node;
+    }
+    return x->cpu - y->cpu;
+}
+
+int cpu_count(void)
+{
+    cpu_set_t set;
+
+    if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+        return CPU_COUNT(&set);
+    }
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? (int)online : 1;
+}
+
+int cpu_topology_load(cpu_topology* topology)
+{
+    cpu_set_t set;
+
+    if (sched_getaffinity(0, sizeof(set), &set) != 0 || CPU_COUNT(&set) == 0) {
+        return -1;
+    }
+
+    int count = CPU_COUNT(&set);
+    cpu_place* places = malloc(sizeof(cpu_place) * count);
+    topology->cpus = malloc(sizeof(int) * count);
+    if (places == NULL || topology->cpus == NULL) {
+        free(places);
+        cpu_topology_free(topology);
+        return -1;
+    }
+
+    int n = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && n < count; cpu++) {
+        if (CPU_ISSET(cpu, &set)) {
+            places[n++] = (cpu_place){cpu, cpu_node(cpu), is_sibling(cpu)};
+        }
+    }
+    qsort(places, n, sizeof(cpu_place), compare_places);
+
+    for (int i = 0; i < n; i++) {
+        topology->cpus[i] = places[i].cpu;
+    }
+    topology->count = n;
+    free(places);
+    return 0;
+}
+
+int cpu_topology_cpu(const cpu_topology* topology, int slot)
+{
+    return topology->cpus[slot % topology->count];
+}
+
+int cpu_pin_thread(int cpu)
+{
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+void cpu_topology_free(cpu_topology* topology)
+{
+    free(topology->cpus);
+    topology->cpus = NULL;
+    topology->count = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef CPU_TOPOLOGY_H_
+#define CPU_TOPOLOGY_H_
+
+//the CPUs this process may run on, ordered for placing threads: the first
+//hardware thread of every core, node by node, then the remaining SMT siblings.
+//Consecutive slots therefore land on distinct cores of the same NUMA node for
+//as long as there are any.
+typedef struct
+{
+    int* cpus;
+    int count;
+}cpu_topology;
+
+//the number of CPUs the process may run on, the online count if the affinity
+//mask cannot be read. The default number of workers.
+int cpu_count(void);
+
+//reads the affinity mask and /sys/devices/system, returns 0 on success.
+//Without sysfs every CPU is taken as a core of its own on node 0.
+int cpu_topology_load(cpu_topology* topology);
+
+//the CPU for placement slot, slots past the last CPU wrap around and share
+//the CPUs of the first slots
+int cpu_topology_cpu(const cpu_topology* topology, int slot);
+
+//pins the calling thread to cpu, returns 0 on success. Memory the thread
+//touches first afterwards comes from cpu's node under the default first-touch
+//policy, so a thread allocates its own buffers after pinning itself.
+int cpu_pin_thread(int cpu);
+
+void cpu_topology_free(cpu_topology* topology);
+
+#endif /* CPU_TOPOLOGY_H_ */
@@ -0,0 +1,56 @@
+#include "delta_batch.h"
+#include "money_atomic.h"
+
+void delta_batch_init(delta_batch* batch)
+{
+    for (int i = 0; i < BATCH_SLOTS; i++) {
+        batch->slots[i].account = -1;
+    }
+    batch->num_touched = 0;
+    batch->pending = 0;
+}
+
+int delta_batch_add(delta_batch* batch, int account, money_t balance, money_t transaction_tracter)
+{
+    unsigned int pos = ((unsigned int)account * 2654435761u) & (BATCH_SLOTS - 1);
+
+    while (batch->slots[pos].account != account) {
+        if (batch->slots[pos].account == -1) {
+            batch->slots[pos].account = account;
+            batch->slots[pos].balance = 0;
+            batch->slots[pos].transaction_tracter = 0;
+            batch->touched[batch->num_touched++] = pos;
+            break;
+        }
+        pos = (pos + 1) & (BATCH_SLOTS - 1);
+    }
+
+    batch->slots[pos].balance += balance;
+    batch->slots[pos].transaction_tracter += transaction_tracter;
+    batch->pending++;
+
+    // merging at half load keeps probe chains short and touched[] from overflowing
+    return batch->num_touched >= BATCH_SLOTS / 2 || batch->pending >= BATCH_MAX_TRANSACTIONS;
+}
+
+void delta_batch_merge(delta_batch* batch, account_store* store, int atomic)
+{
+    for (int t = 0; t < batch->num_touched; t++) {
+        account_delta* delta = &batch->slots[batch->touched[t]];
+        account_state* state = &store->state[delta->account];
+
+        if (atomic) {
+            money_atomic_add(&state->balance, delta->balance);
+            money_atomic_add(&state->transaction_tracter, delta->transaction_tracter);
+        } else {
+            pthread_mutex_lock(&state->lock);
+            money_atomic_store(&state->balance, state->balance + delta->balance); // read unlocked by checks
+            state->transaction_tracter += delta->transaction_tracter;
+            pthread_mutex_unlock(&state->lock);
+        }
+        delta->account = -1;
+    }
+
+    batch->num_touched = 0;
+    batch->pending = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef DELTA_BATCH_H_
+#define DELTA_BATCH_H_
+
+#include "account_store.h"
+#include "money.h"
+
+#define BATCH_SLOTS 1024            // power of two
+#define BATCH_MAX_TRANSACTIONS 4096 // transactions folded in before a merge is due
+
+//what one worker has deposited and withdrawn on an account since its last merge
+typedef struct
+{
+    int account;                // -1 marks an empty slot
+    money_t balance;
+    money_t transaction_tracter;
+}account_delta;
+
+//a worker's private table of pending per-account deltas, nothing in here is
+//shared so folding a transaction in takes no lock
+typedef struct
+{
+    account_delta slots[BATCH_SLOTS];
+    int touched[BATCH_SLOTS / 2];   // slots in use, so a merge skips the empty ones
+    int num_touched;
+    int pending;                    // transactions folded in since the last merge
+}delta_batch;
+
+void delta_batch_init(delta_batch* batch);
+
+//folds a balance and tracter change for account into the batch, returns 1 once
+//the batch is full enough that the caller should merge it
+int delta_batch_add(delta_batch* batch, int account, money_t balance, money_t transaction_tracter);
+
+//applies every pending delta to the shared store, taking each touched account's
+//lock once (or none with atomic set), and empties the batch
+void delta_batch_merge(delta_batch* batch, account_store* store, int atomic);
+
+#endif /* DELTA_BATCH_H_ */
@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+
+#define ACCOUNT_SPACE 10000000000000000ULL  // account numbers have 16 digits
+#define ACCOUNT_MULTIPLIER 6364136223846793ULL  // coprime to ACCOUNT_SPACE, so numbers never repeat
+#define PASSWORD_LENGTH 8
+#define MIN_BALANCE_CENTS 100000ULL         // opening balances between $1,000 and $5,000,000
+#define MAX_BALANCE_CENTS 500000000ULL
+#define MIN_AMOUNT_CENTS 100ULL             // transaction amounts between $1 and $5,000
+#define MAX_AMOUNT_CENTS 500000ULL
+#define OUTPUT_BUFFER (1 << 20)
+
+// Writes a bank input file: the account count, an "index N" block per account
+// and then D/W/T/C lines, in the format part1, part2 and Part3 read. Account
+// popularity follows a Zipf law with exponent -z (0 for uniform), transfer
+// destinations too. A fraction -p of the commands carries a wrong password.
+// The same options and seed always give the same file.
+//
+//   ./generate -a 1000000 -n 10000000 -x 30:25:25:20 -z 1.1 -p 0.02 -s 7 -o load.txt
+
+typedef struct {
+    double exponent;
+    long num_ranks;
+    double h_integral_x1;
+    double h_integral_n;
+    double s;
+} zipf_sampler;
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// A value in [0, 1) with 53 random bits
+static double uniform01(uint64_t *state) {
+    return (splitmix64(state) >> 11) * 0x1.0p-53;
+}
+
+static uint64_t uniform_below(uint64_t *state, uint64_t bound) {
+    return (uint64_t)(uniform01(state) * bound);
+}
+
+// Zipf sampling by rejection-inversion (Hörmann and Derflinger), O(1) per
+// sample without a table over the ranks. helper1 and helper2 keep the
+// integral of x^-s accurate when the exponent is close to 1.
+static double helper1(double x) {
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+}
+
+static double helper2(double x) {
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+}
+
+static double zipf_h(const zipf_sampler *zipf, double x) {
+    return exp(-zipf->exponent * log(x));
+}
+
+static double zipf_h_integral(const zipf_sampler *zipf, double x) {
+    double log_x = log(x);
+    return helper2((1 - zipf->exponent) * log_x) * log_x;
+}
+
+static double zipf_h_integral_inverse(const zipf_sampler *zipf, double x) {
+    double t = x * (1 - zipf->exponent);
+    if (t < -1) {
+        t = -1; // rounding can push t just past the pole
+    }
+    return exp(helper1(t) * x);
+}
+
+static void zipf_init(zipf_sampler *zipf, long num_ranks, double exponent) {
+    zipf->exponent = exponent;
+    zipf->num_ranks = num_ranks;
+    zipf->h_integral_x1 = zipf_h_integral(zipf, 1.5) - 1;
+    zipf->h_integral_n = zipf_h_integral(zipf, num_ranks + 0.5);
+    zipf->s = 2 - zipf_h_integral_inverse(zipf, zipf_h_integral(zipf, 2.5) - zipf_h(zipf, 2));
+}
+
+// A rank in [1, num_ranks], rank 1 being the most likely
+static long zipf_sample(const zipf_sampler *zipf, uint64_t *state) {
+    while (1) {
+        double u = zipf->h_integral_n + uniform01(state) * (zipf->h_integral_x1 - zipf->h_integral_n);
+        double x = zipf_h_integral_inverse(zipf, u);
+        long k = (long)(x + 0.5);
+
+        if (k < 1) {
+            k = 1;
+        } else if (k > zipf->num_ranks) {
+            k = zipf->num_ranks;
+        }
+        if (k - x <= zipf->s || u >= zipf_h_integral(zipf, k + 0.5) - zipf_h(zipf, k)) {
+            return k;
+        }
+    }
+}
+
+static uint64_t gcd(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// Account fields are derived from the seed and the index alone, so the
+// transactions can name any account without keeping the header in memory
+static void account_number(uint64_t seed, long index, char *out) {
+    uint64_t offset = splitmix64(&seed) % ACCOUNT_SPACE;
+    uint64_t number = (uint64_t)(((unsigned __int128)index * ACCOUNT_MULTIPLIER + offset) % ACCOUNT_SPACE);
+    for (int i = 15; i >= 0; i--) {
+        out[i] = '0' + number % 10;
+        number /= 10;
+    }
+    out[16] = '\0';
+}
+
+static void account_password(uint64_t seed, long index, char *out) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    uint64_t state = seed ^ (0x5851f42d4c957f2dULL * (index + 1));
+    uint64_t bits = splitmix64(&state);
+
+    for (int i = 0; i < PASSWORD_LENGTH; i++) {
+        out[i] = alphabet[bits % 36];
+        bits /= 36;
+    }
+    out[PASSWORD_LENGTH] = '\0';
+}
+
+// Same length as the real password and never equal to it
+static void wrong_password(const char *password, char *out) {
+    strcpy(out, password);
+    out[0] = out[0] == 'z' ? 'a' : out[0] + 1;
+    if (out[0] == '9' + 1) {
+        out[0] = 'a';
+    }
+}
+
+static int put_cents(char *out, uint64_t cents) {
+    return sprintf(out, "%llu.%02llu", (unsigned long long)(cents / 100), (unsigned long long)(cents % 100));
+}
+
+static int parse_mix(const char *text, double cumulative[4]) {
+    double weights[4], total = 0;
+
+    if (sscanf(text, "%lf:%lf:%lf:%lf", &weights[0], &weights[1], &weights[2], &weights[3]) != 4) {
+        return -1;
+    }
+    for (int i = 0; i < 4; i++) {
+        if (weights[i] < 0) {
+            return -1;
+        }
+        total += weights[i];
+    }
+    if (total <= 0) {
+        return -1;
+    }
+    for (int i = 0; i < 4; i++) {
+        cumulative[i] = (i > 0 ? cumulative[i - 1] : 0) + weights[i] / total;
+    }
+    cumulative[3] = 1.0;
+    return 0;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-a accounts] [-n transactions] [-x D:W:T:C] [-z zipf_exponent] "
+                    "[-p bad_password_fraction] [-s seed] [-o output_file]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+    long num_accounts = 10;
+    long num_transactions = 1000;
+    double mix[4];
+    double exponent = 0;
+    double bad_fraction = 0;
+    uint64_t seed = 1;
+    const char *output_path = NULL;
+    int opt;
+
+    parse_mix("30:25:25:20", mix);
+    while ((opt = getopt(argc, argv, "a:n:x:z:p:s:o:")) != -1) {
+        switch (opt) {
+        case 'a':
+            num_accounts = atol(optarg);
+            break;
+        case 'n':
+            num_transactions = atol(optarg);
+            break;
+        case 'x': // relative weights of deposits, withdrawals, transfers and checks
+            if (parse_mix(optarg, mix) != 0) {
+                fprintf(stderr, "Bad command mix %s, expected four weights like 30:25:25:20\n", optarg);
+                return 1;
+            }
+            break;
+        case 'z':
+            exponent = atof(optarg);
+            break;
+        case 'p':
+            bad_fraction = atof(optarg);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'o':
+            output_path = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc || num_accounts < 1 || num_accounts > 0x7fffffff || num_transactions < 0 ||
+        exponent < 0 || bad_fraction < 0 || bad_fraction > 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE *output = output_path != NULL ? fopen(output_path, "w") : stdout;
+    if (!output) {
+        perror("Error opening output file");
+        return 1;
+    }
+    setvbuf(output, NULL, _IOFBF, OUTPUT_BUFFER);
+
+    char line[256];
+    char number[17], dest_number[17], password[PASSWORD_LENGTH + 1], wrong[PASSWORD_LENGTH + 1];
+    uint64_t state = seed;
+
+    fprintf(output, "%ld\n", num_accounts);
+    for (long i = 0; i < num_accounts; i++) {
+        int length = sprintf(line, "index %ld\n", i);
+
+        account_number(seed, i, number);
+        account_password(seed, i, password);
+        length += sprintf(line + length, "%s\n%s\n", number, password);
+        length += put_cents(line + length, MIN_BALANCE_CENTS + uniform_below(&state, MAX_BALANCE_CENTS - MIN_BALANCE_CENTS));
+        length += sprintf(line + length, "\n0.%03d\n", 1 + (int)uniform_below(&state, 50));
+        fwrite(line, 1, length, output);
+    }
+
+    // popularity ranks are scattered over the indices, so the hot accounts are
+    // not all neighbours in the header
+    uint64_t scatter = (uint64_t)(num_accounts * 0.6180339887) | 1;
+    while (gcd(scatter, num_accounts) != 1) {
+        scatter++;
+    }
+
+    zipf_sampler zipf;
+    zipf_init(&zipf, num_accounts, exponent);
+
+    for (long t = 0; t < num_transactions; t++) {
+        long src, dest = 0;
+        double pick = uniform01(&state);
+        char type = pick < mix[0] ? 'D' : pick < mix[1] ? 'W' : pick < mix[2] ? 'T' : 'C';
+
+        if (exponent > 0) {
+            src = (long)((uint64_t)(zipf_sample(&zipf, &state) - 1) * scatter % num_accounts);
+        } else {
+            src = (long)uniform_below(&state, num_accounts);
+        }
+        if (type == 'T') {
+            do { // a transfer to a different account whenever there is one
+                if (exponent > 0) {
+                    dest = (long)((uint64_t)(zipf_sample(&zipf, &state) - 1) * scatter % num_accounts);
+                } else {
+                    dest = (long)uniform_below(&state, num_accounts);
+                }
+            } while (dest == src && num_accounts > 1);
+        }
+
+        account_number(seed, src, number);
+        account_password(seed, src, password);
+        const char *given = password;
+        if (uniform01(&state) < bad_fraction) {
+            wrong_password(password, wrong);
+            given = wrong;
+        }
+
+        int length = sprintf(line, "%c %s %s", type, number, given);
+        if (type == 'T') {
+            account_number(seed, dest, dest_number);
+            length += sprintf(line + length, " %s", dest_number);
+        }
+        if (type != 'C') {
+            line[length++] = ' ';
+            length += put_cents(line + length, MIN_AMOUNT_CENTS + uniform_below(&state, MAX_AMOUNT_CENTS - MIN_AMOUNT_CENTS));
+        }
+        line[length++] = '\n';
+        fwrite(line, 1, length, output);
+    }
+
+    if (fclose(output) != 0) {
+        perror("Error writing output file");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "input_reader.h"
+
+int mapped_input_open(mapped_input* input, const char* path, size_t body)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    input->size = st.st_size;
+    input->body = body < input->size ? body : input->size;
+    input->data = NULL;
+    if (input->size > 0) {
+        void* data = mmap(NULL, input->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        madvise(data, input->size, MADV_SEQUENTIAL);
+        input->data = data;
+    }
+    close(fd); // the mapping keeps its own reference to the file
+
+    input->num_chunks = (input->size - input->body + INPUT_CHUNK_SIZE - 1) / INPUT_CHUNK_SIZE;
+    input->end_chunk = input->num_chunks;
+    atomic_init(&input->next_chunk, 0);
+    return 0;
+}
+
+// A chunk owns every line that starts inside it, so both ends are moved forward
+// to the next line start and neighbouring chunks never split a line
+static const char* line_start_at(const mapped_input* input, size_t offset)
+{
+    const char* end = input->data + input->size;
+    if (offset >= input->size) {
+        return end;
+    }
+    if (offset == input->body || input->data[offset - 1] == '\n') {
+        return input->data + offset;
+    }
+
+    const char* newline = memchr(input->data + offset, '\n', input->size - offset);
+    return newline ? newline + 1 : end;
+}
+
+static int claim_chunk(mapped_input* input, input_cursor* cursor)
+{
+    while (1) {
+        size_t chunk = atomic_fetch_add_explicit(&input->next_chunk, 1, memory_order_relaxed);
+        if (chunk >= input->end_chunk) {
+            return 0;
+        }
+
+        size_t start = input->body + chunk * INPUT_CHUNK_SIZE;
+        cursor->pos = line_start_at(input, start);
+        cursor->end = line_start_at(input, start + INPUT_CHUNK_SIZE);
+        if (cursor->pos < cursor->end) {
+            return 1;
+        }
+        // a single line longer than the chunk, its owner already took it
+    }
+}
+
+int mapped_input_next_line(mapped_input* input, input_cursor* cursor, char* buffer, size_t size)
+{
+    if (cursor->pos == NULL || cursor->pos >= cursor->end) {
+        if (!claim_chunk(input, cursor)) {
+            return 0;
+        }
+    }
+
+    const char* newline = memchr(cursor->pos, '\n', cursor->end - cursor->pos);
+    const char* line_end = newline ? newline + 1 : cursor->end;
+    size_t len = line_end - cursor->pos;
+
+    // overlong lines are truncated to the buffer, the rest of the line is skipped
+    if (len > size - 1) {
+        len = size - 1;
+    }
+    memcpy(buffer, cursor->pos, len);
+    buffer[len] = '\0';
+
+    cursor->pos = line_end;
+    return 1;
+}
+
+void mapped_input_segment(mapped_input* input, size_t first_chunk, size_t end_chunk)
+{
+    input->end_chunk = end_chunk < input->num_chunks ? end_chunk : input->num_chunks;
+    atomic_store(&input->next_chunk, first_chunk);
+}
+
+size_t mapped_input_offset(const mapped_input* input, size_t chunk)
+{
+    if (chunk >= input->num_chunks) {
+        return input->size;
+    }
+    return line_start_at(input, input->body + chunk * INPUT_CHUNK_SIZE) - input->data;
+}
+
+void mapped_input_close(mapped_input* input)
+{
+    if (input == NULL) return;
+
+    if (input->data != NULL) {
+        munmap((void*)input->data, input->size);
+        input->data = NULL;
+    }
+    input->size = 0;
+}
@@ -0,0 +1,49 @@
+#ifndef MONEY_ATOMIC_H_
+#define MONEY_ATOMIC_H_
+
+#include "money.h"
+
+//Lock-free access to money_t fields shared between part2's workers, and the
+//drift allowed when checking their sums. Kept out of money.h, which is shared
+//with part1 and Part3 where nothing is updated concurrently.
+
+#ifdef FIXED_POINT
+// sums of cents are exact, no drift is tolerated
+#define MONEY_TOLERANCE(total) 0
+#else
+// rounding error allowed when comparing two ways of summing the same balances
+#define MONEY_TOLERANCE(total) (0.005 + 1e-12 * ((total) < 0 ? -(total) : (total)))
+#endif
+
+//adds delta to *target without a lock, as a fetch-add on integer cents or a
+//compare-and-swap loop on doubles
+static inline void money_atomic_add(money_t* target, money_t delta)
+{
+#ifdef FIXED_POINT
+    __atomic_fetch_add(target, delta, __ATOMIC_RELAXED);
+#else
+    money_t expected, desired;
+
+    __atomic_load(target, &expected, __ATOMIC_RELAXED);
+    do {
+        desired = expected + delta;
+    } while (!__atomic_compare_exchange(target, &expected, &desired, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+#endif
+}
+
+static inline money_t money_atomic_load(money_t* source)
+{
+    money_t value;
+    __atomic_load(source, &value, __ATOMIC_RELAXED);
+    return value;
+}
+
+//stores value as a single untorn write, for fields written under a lock but
+//read without one
+static inline void money_atomic_store(money_t* target, money_t value)
+{
+    __atomic_store(target, &value, __ATOMIC_RELAXED);
+}
+
+#endif /* MONEY_ATOMIC_H_ */
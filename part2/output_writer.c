@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "output_writer.h"
+
+#define MAX_OUTPUT_THREADS 64
+#define OUTPUT_LINE_ESTIMATE 32     // "123456 balance:\t1234.56\n\n" is 26 bytes
+#define OUTPUT_LINE_MAX (10 + sizeof(" balance:\t") + MONEY_TEXT_MAX + 2)
+
+typedef struct
+{
+    const money_t* balance;
+    size_t balance_stride;
+    int start;                  // the thread formats accounts [start, end)
+    int end;
+    char* text;
+    size_t length;
+    int failed;
+}output_range;
+
+static int format_index(char* text, unsigned int index)
+{
+    char digits[10];
+    int length = 0;
+
+    do {
+        digits[length++] = '0' + index % 10;
+        index /= 10;
+    } while (index > 0);
+    for (int i = 0; i < length; i++) {
+        text[i] = digits[length - 1 - i];
+    }
+    return length;
+}
+
+static void* format_range(void* arg)
+{
+    output_range* range = (output_range*)arg;
+    size_t capacity = (size_t)(range->end - range->start) * OUTPUT_LINE_ESTIMATE + OUTPUT_LINE_MAX;
+    char* text = malloc(capacity);
+    size_t length = 0;
+
+    for (int i = range->start; i < range->end && text != NULL; i++) {
+        // only balances near DBL_MAX need more than the estimate
+        if (capacity - length < OUTPUT_LINE_MAX) {
+            char* grown = realloc(text, capacity * 2);
+            if (grown == NULL) {
+                free(text);
+                text = NULL;
+                break;
+            }
+            text = grown;
+            capacity *= 2;
+        }
+
+        money_t balance = *(const money_t*)((const char*)range->balance + range->balance_stride * i);
+        length += format_index(text + length, i);
+        memcpy(text + length, " balance:\t", 10);
+        length += 10;
+        length += money_format(text + length, balance);
+        text[length++] = '\n';
+        text[length++] = '\n';
+    }
+
+    range->text = text;
+    range->length = length;
+    range->failed = text == NULL;
+    return NULL;
+}
+
+static int write_all(int fd, const char* text, size_t length)
+{
+    while (length > 0) {
+        ssize_t written = write(fd, text, length);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        text += written;
+        length -= written;
+    }
+    return 0;
+}
+
+int output_write(const char* path, const money_t* balance, size_t balance_stride,
+                 int num_accounts, int num_threads)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1) {
+        return -1;
+    }
+
+    int max_threads = num_accounts / OUTPUT_MIN_ACCOUNTS_PER_THREAD;
+    if (num_threads > max_threads) num_threads = max_threads;
+    if (num_threads > MAX_OUTPUT_THREADS) num_threads = MAX_OUTPUT_THREADS;
+    if (num_threads < 1) num_threads = 1;
+
+    output_range ranges[MAX_OUTPUT_THREADS];
+    pthread_t threads[MAX_OUTPUT_THREADS];
+    int started[MAX_OUTPUT_THREADS] = {0};
+
+    for (int t = 0; t < num_threads; t++) {
+        ranges[t] = (output_range){balance, balance_stride,
+                                   (int)((long)num_accounts * t / num_threads),
+                                   (int)((long)num_accounts * (t + 1) / num_threads), NULL, 0, 0};
+    }
+    for (int t = 1; t < num_threads; t++) {
+        started[t] = pthread_create(&threads[t], NULL, format_range, &ranges[t]) == 0;
+    }
+    format_range(&ranges[0]);
+    for (int t = 1; t < num_threads; t++) {
+        // a range whose thread could not be started is formatted here instead
+        if (started[t]) {
+            pthread_join(threads[t], NULL);
+        } else {
+            format_range(&ranges[t]);
+        }
+    }
+
+    // the ranges are written in account order, each with as few writes as it takes
+    int failed = 0;
+    for (int t = 0; t < num_threads; t++) {
+        if (ranges[t].failed) {
+            errno = ENOMEM;
+            failed = 1;
+        } else if (!failed && write_all(fd, ranges[t].text, ranges[t].length) != 0) {
+            failed = 1;
+        }
+        free(ranges[t].text);
+    }
+
+    int saved_errno = errno;
+    if (close(fd) != 0 && !failed) {
+        return -1;
+    }
+    errno = saved_errno;
+    return failed ? -1 : 0;
+}
@@ -1,13 +1,89 @@
 #!/bin/bash
 
+# Stress harness for the bank. Runs the same input COUNT times and stops at the
+# first run that deadlocks (no exit within RUN_TIMEOUT seconds), breaks the money
+# invariant (./bank -v exits with 2) or writes an out.txt different from the
+# first run. Reports transfer throughput over all runs at the end.
+#
+#   ./runner.sh [input_file] [count]
+#   BANK_FLAGS="-a -m" ./runner.sh input-1.txt 1000
+#
+# The double build's balances can drift by rounding between runs, so out.txt is
+# compared with a per-balance TOLERANCE (default 0.01). A build with
+# make FIXED_POINT=1 is byte-identical between runs, set EXACT=1 to compare it
+# byte for byte. With BANK_FLAGS=-D out.txt and ledger.txt are byte-identical in
+# either build, both are compared byte for byte.
 
-SCRIPT_TO_RUN="./bank input-1.txt"  # EDIT THIS WITH THE SCRIPT YOU WANT TO RUN. THIS IS HOW WE WILL TEST YOUR PROJ 3 FOR DEADLOCKS
+INPUT=${1:-input-1.txt}
 
 # num times to run the script
-COUNT=10000
+COUNT=${2:-10000}
+RUN_TIMEOUT=${RUN_TIMEOUT:-60}
+
+SCRIPT_TO_RUN="./bank -v $BANK_FLAGS $INPUT"
+
+TOLERANCE=${TOLERANCE:-0.01}
+if [[ " $BANK_FLAGS " == *" -D "* ]]; then
+  EXACT=1
+fi
+
+# same_output <file> <first_file>: byte for byte with EXACT=1, otherwise the
+# same lines with numeric fields at most TOLERANCE apart
+same_output() {
+  if [ "$EXACT" = "1" ]; then
+    cmp -s "$1" "$2"
+    return
+  fi
+  awk -v tolerance="$TOLERANCE" '
+    FNR == NR { first[FNR] = $0; lines = FNR; next }
+    {
+      if (!(FNR in first)) exit 1
+      n = split(first[FNR], a); m = split($0, b)
+      if (n != m) exit 1
+      for (i = 1; i <= n; i++) {
+        if (a[i] == b[i]) continue
+        d = a[i] - b[i]
+        if (a[i] !~ /^-?[0-9.]+$/ || b[i] !~ /^-?[0-9.]+$/ || d > tolerance + 1e-9 || -d > tolerance + 1e-9) exit 1
+      }
+    }
+    END { if (FNR != lines) exit 1 }' "$2" "$1"
+}
+
+TRANSFERS=$(grep -c '^T ' "$INPUT")
+TOTAL_NS=0
 
 for ((i=1; i<=COUNT; i++))
 do
   echo "Running iteration $i"
-  $SCRIPT_TO_RUN
+
+  START_NS=$(date +%s%N)
+  timeout "$RUN_TIMEOUT" $SCRIPT_TO_RUN
+  STATUS=$?
+  END_NS=$(date +%s%N)
+  TOTAL_NS=$((TOTAL_NS + END_NS - START_NS))
+
+  if [ $STATUS -eq 124 ]; then
+    echo "Iteration $i did not finish within ${RUN_TIMEOUT}s, probable deadlock"
+    exit 1
+  elif [ $STATUS -ne 0 ]; then
+    echo "Iteration $i failed with status $STATUS"
+    exit 1
+  fi
+
+  if [ $i -eq 1 ]; then
+    cp out.txt out.first.txt
+    cp ledger.txt ledger.first.txt
+  elif ! same_output out.txt out.first.txt; then
+    echo "Iteration $i produced a different out.txt than iteration 1"
+    exit 1
+  elif [[ " $BANK_FLAGS " == *" -D "* ]] && ! cmp -s ledger.txt ledger.first.txt; then
+    echo "Iteration $i produced a different ledger.txt than iteration 1"
+    exit 1
+  fi
 done
+
+rm -f out.first.txt ledger.first.txt
+echo "$COUNT runs passed, $TRANSFERS transfers per run"
+if [ $TOTAL_NS -gt 0 ]; then
+  echo "Transfer throughput: $((TRANSFERS * COUNT * 1000000000 / TOTAL_NS)) transfers/s (whole-run wall time)"
+fi
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+
+#ifdef FIXED_POINT
+#define SNAPSHOT_FIXED_POINT 1
+#else
+#define SNAPSHOT_FIXED_POINT 0
+#endif
+
+#define SNAPSHOT_STATE_BATCH 4096   // states converted and written at a time
+
+int snapshot_write(const char* path, account_store* store, const snapshot_header* info)
+{
+    char temp_path[4096];
+    snapshot_header header = *info;
+    snapshot_state batch[SNAPSHOT_STATE_BATCH];
+
+    if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path)) {
+        return -1;
+    }
+    FILE* out = fopen(temp_path, "wb");
+    if (out == NULL) {
+        return -1;
+    }
+
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.num_accounts = store->num_accounts;
+    header.fixed_point = SNAPSHOT_FIXED_POINT;
+
+    int failed = fwrite(&header, sizeof(header), 1, out) != 1 ||
+                 fwrite(store->accounts, sizeof(Account), store->num_accounts, out) != (size_t)store->num_accounts;
+
+    for (int i = 0; i < store->num_accounts && !failed; i += SNAPSHOT_STATE_BATCH) {
+        int count = store->num_accounts - i < SNAPSHOT_STATE_BATCH ? store->num_accounts - i : SNAPSHOT_STATE_BATCH;
+        for (int j = 0; j < count; j++) {
+            batch[j].balance = store->state[i + j].balance;
+            batch[j].transaction_tracter = store->state[i + j].transaction_tracter;
+        }
+        failed = fwrite(batch, sizeof(snapshot_state), count, out) != (size_t)count;
+    }
+
+    // the data has to be on disk before the rename makes it the snapshot
+    failed |= fflush(out) != 0 || fsync(fileno(out)) != 0;
+    failed |= fclose(out) != 0;
+    if (failed || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+        return -1;
+    }
+    return 0;
+}
+
+int snapshot_open(snapshot* snap, const char* path)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(snapshot_header)) {
+        close(fd);
+        return -1;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps its own reference to the file
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    const snapshot_header* header = map;
+    size_t expected = sizeof(snapshot_header) +
+                      (size_t)header->num_accounts * (sizeof(Account) + sizeof(snapshot_state));
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SNAPSHOT_VERSION || header->fixed_point != SNAPSHOT_FIXED_POINT ||
+        header->num_accounts > 0x7fffffff || (size_t)st.st_size != expected) {
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    snap->map = map;
+    snap->map_size = st.st_size;
+    snap->header = header;
+    snap->accounts = (const Account*)(header + 1);
+    snap->state = (const snapshot_state*)(snap->accounts + header->num_accounts);
+    return 0;
+}
+
+void snapshot_restore(const snapshot* snap, account_store* store)
+{
+    memcpy(store->accounts, snap->accounts, sizeof(Account) * snap->header->num_accounts);
+    for (uint32_t i = 0; i < snap->header->num_accounts; i++) {
+        store->state[i].balance = snap->state[i].balance;
+        store->state[i].transaction_tracter = snap->state[i].transaction_tracter;
+    }
+}
+
+void snapshot_close(snapshot* snap)
+{
+    if (snap == NULL) return;
+
+    if (snap->map != NULL) {
+        munmap(snap->map, snap->map_size);
+        snap->map = NULL;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "account.h"
+#include "account_store.h"
+#include "money.h"
+
+#define SNAPSHOT_MAGIC "DUCKSNP"
+#define SNAPSHOT_VERSION 2
+
+//snapshot file: one snapshot_header, num_accounts Account records, then
+//num_accounts snapshot_state records, all in host byte order
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_accounts;
+    uint64_t position;          // next unread byte of the input file, or record of the compiled log
+    uint8_t compiled;           // position counts records of a compiled log
+    uint8_t fixed_point;        // money_t was integer cents when the snapshot was written
+    uint8_t reserved[6];
+    int64_t check_balance_count;
+    int64_t logged_checks;
+    uint64_t input_size;        // size and modification time of the input or compiled log position is in
+    int64_t input_mtime;
+    uint64_t ledger_records;    // ledger.txt lines written before the snapshot
+}snapshot_header;
+
+typedef struct
+{
+    money_t balance;
+    money_t transaction_tracter;
+}snapshot_state;
+
+//a snapshot mapped read-only for restoring
+typedef struct
+{
+    void* map;
+    size_t map_size;
+    const snapshot_header* header;
+    const Account* accounts;
+    const snapshot_state* state;
+}snapshot;
+
+//writes the store and the header fields in info to path. The file is written
+//next to path and renamed over it, so a crash leaves the previous snapshot.
+int snapshot_write(const char* path, account_store* store, const snapshot_header* info);
+
+//maps a snapshot and checks it is complete and was written by a build with
+//the same money_t, returns 0 on success
+int snapshot_open(snapshot* snap, const char* path);
+
+//copies the mapped accounts and balances into a store of header->num_accounts
+void snapshot_restore(const snapshot* snap, account_store* store);
+
+void snapshot_close(snapshot* snap);
+
+#endif /* SNAPSHOT_H_ */
@@ -0,0 +1,21 @@
+#ifndef TRANSACTION_H_
+#define TRANSACTION_H_
+
+#include "account_index.h"
+#include "money.h"
+
+//a transaction request with its accounts already looked up
+typedef struct
+{
+    char type;          // 'D', 'W', 'T' or 'C'
+    int authorized;     // the password matched the source account
+    int src;            // account position, -1 when the number is unknown
+    int dest;           // transfers only, -1 otherwise
+    money_t amount;
+}transaction;
+
+//tokenizes line in place and resolves it against the account index, returns 0
+//for blank lines, unknown command types and lines missing arguments
+int transaction_parse(char* line, const account_index* index, transaction* txn);
+
+#endif /* TRANSACTION_H_ */
@@ -0,0 +1,104 @@
+#include <stdlib.h>
+#include <string.h>
+#include "txn_dispatch.h"
+
+#define RANGE(low, high) ((uint64_t)(low) << 32 | (uint32_t)(high))
+#define RANGE_LOW(range) ((int)((range) >> 32))
+#define RANGE_HIGH(range) ((int)(uint32_t)(range))
+
+int txn_dispatch_init(txn_dispatch* dispatch, int num_workers)
+{
+    memset(dispatch, 0, sizeof(*dispatch));
+    dispatch->num_workers = num_workers;
+    dispatch->txns = malloc(DISPATCH_BATCH * sizeof(dispatched_txn));
+    dispatch->entries = malloc(2 * DISPATCH_BATCH * sizeof(dispatch_entry));
+    dispatch->ranges = calloc(num_workers, sizeof(*dispatch->ranges));
+    if (dispatch->txns == NULL || dispatch->entries == NULL || dispatch->ranges == NULL) {
+        txn_dispatch_free(dispatch);
+        return -1;
+    }
+    return 0;
+}
+
+// A transfer to another account also has a credit entry
+static int has_credit(const transaction* txn)
+{
+    return txn->type == 'T' && txn->dest >= 0 && txn->dest != txn->src;
+}
+
+void txn_dispatch_prepare(txn_dispatch* dispatch, int count)
+{
+    int part_count[DISPATCH_PARTITIONS] = {0};
+    int part_pos[DISPATCH_PARTITIONS];
+
+    for (int i = 0; i < count; i++) {
+        const transaction* txn = &dispatch->txns[i].txn;
+        if (txn->src >= 0) {
+            part_count[txn->src % DISPATCH_PARTITIONS]++;
+            if (has_credit(txn)) {
+                part_count[txn->dest % DISPATCH_PARTITIONS]++;
+            }
+        }
+    }
+
+    int num_tasks = 0;
+    dispatch->part_start[0] = 0;
+    for (int p = 0; p < DISPATCH_PARTITIONS; p++) {
+        dispatch->part_start[p + 1] = dispatch->part_start[p] + part_count[p];
+        part_pos[p] = dispatch->part_start[p];
+        if (part_count[p] > 0) {
+            dispatch->tasks[num_tasks++] = p;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        const transaction* txn = &dispatch->txns[i].txn;
+        if (txn->src >= 0) {
+            dispatch->entries[part_pos[txn->src % DISPATCH_PARTITIONS]++] = (dispatch_entry){i, 0};
+            if (has_credit(txn)) {
+                dispatch->entries[part_pos[txn->dest % DISPATCH_PARTITIONS]++] = (dispatch_entry){i, 1};
+            }
+        }
+    }
+
+    for (int w = 0; w < dispatch->num_workers; w++) {
+        atomic_store(&dispatch->ranges[w], RANGE(num_tasks * w / dispatch->num_workers,
+                                                 num_tasks * (w + 1) / dispatch->num_workers));
+    }
+    dispatch->count = count;
+}
+
+// Takes a task from the front of a range (the owner) or from its back (a thief)
+static int take_task(txn_dispatch* dispatch, int worker, int from_back)
+{
+    _Atomic uint64_t* slot = &dispatch->ranges[worker];
+    uint64_t range = atomic_load_explicit(slot, memory_order_acquire);
+
+    while (RANGE_LOW(range) < RANGE_HIGH(range)) {
+        int low = RANGE_LOW(range), high = RANGE_HIGH(range);
+        uint64_t taken = from_back ? RANGE(low, high - 1) : RANGE(low + 1, high);
+
+        if (atomic_compare_exchange_weak_explicit(slot, &range, taken, memory_order_acq_rel,
+                                                  memory_order_acquire)) {
+            return dispatch->tasks[from_back ? high - 1 : low];
+        }
+    }
+    return -1;
+}
+
+int txn_dispatch_claim(txn_dispatch* dispatch, int worker)
+{
+    int partition = take_task(dispatch, worker, 0);
+
+    for (int w = 1; partition < 0 && w < dispatch->num_workers; w++) {
+        partition = take_task(dispatch, (worker + w) % dispatch->num_workers, 1);
+    }
+    return partition;
+}
+
+void txn_dispatch_free(txn_dispatch* dispatch)
+{
+    free(dispatch->ranges);
+    free(dispatch->entries);
+    free(dispatch->txns);
+    memset(dispatch, 0, sizeof(*dispatch));
+}
@@ -0,0 +1,55 @@
+#ifndef TXN_DISPATCH_H_
+#define TXN_DISPATCH_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "transaction.h"
+
+#define DISPATCH_BATCH 65536            // transactions dispatched together
+#define DISPATCH_PARTITIONS 256         // accounts are split by index modulo this, the unit of stealing
+
+//a transaction of the batch
+typedef struct
+{
+    transaction txn;            // src is -1 for lines that touch no account
+    int logged;                 // a sampled balance check to write to the ledger
+    money_t seen;               // the balance a logged check read
+}dispatched_txn;
+
+//an entry of a partition: the side of a transaction that touches one of the
+//partition's accounts, a transfer's debit in the source's partition and its
+//credit in the destination's
+typedef struct
+{
+    int position;               // in the batch
+    int credit;                 // the destination side of a transfer
+}dispatch_entry;
+
+//Partitions a batch by account so every account's changes run in file order
+//and no two workers ever touch the same account. Each partition lists its
+//entries in file order. Each worker starts with a range of partitions and
+//steals single partitions from the back of the others' ranges once its own is
+//used up.
+typedef struct
+{
+    int num_workers;
+    dispatched_txn* txns;                   // the batch in file order
+    int count;
+    dispatch_entry* entries;                // grouped by partition, file order within each
+    int part_start[DISPATCH_PARTITIONS + 1];
+    int tasks[DISPATCH_PARTITIONS];         // the partitions holding entries
+    _Atomic uint64_t* ranges;               // per worker, tasks [low, high) packed as low << 32 | high
+}txn_dispatch;
+
+int txn_dispatch_init(txn_dispatch* dispatch, int num_workers);
+
+//groups the entries of txns[0, count) by partition and splits the partitions
+//between the workers. Only while no worker runs the batch.
+void txn_dispatch_prepare(txn_dispatch* dispatch, int count);
+
+//the next partition for worker to run, -1 once every partition has been taken
+int txn_dispatch_claim(txn_dispatch* dispatch, int worker);
+
+void txn_dispatch_free(txn_dispatch* dispatch);
+
+#endif /* TXN_DISPATCH_H_ */
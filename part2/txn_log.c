@@ -0,0 +1,144 @@
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "txn_log.h"
+
+static void fill_header(txn_log_header* header, int num_accounts, uint64_t num_records)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, TXN_LOG_MAGIC, sizeof(TXN_LOG_MAGIC));
+    header->version = TXN_LOG_VERSION;
+    header->num_accounts = num_accounts;
+    header->num_records = num_records;
+}
+
+int txn_log_begin(FILE* out, int num_accounts)
+{
+    txn_log_header header;
+    fill_header(&header, num_accounts, 0);
+    return fwrite(&header, sizeof(header), 1, out) == 1 ? 0 : -1;
+}
+
+int txn_log_append(FILE* out, const transaction* txn)
+{
+    txn_record record;
+
+    memset(&record, 0, sizeof(record));
+    record.amount = money_to_cents(txn->amount);
+    record.src = txn->src;
+    record.dest = txn->dest;
+    record.type = txn->type;
+    record.flags = txn->authorized ? TXN_AUTHORIZED : 0;
+
+    return fwrite(&record, sizeof(record), 1, out) == 1 ? 0 : -1;
+}
+
+int txn_log_finish(FILE* out, int num_accounts, uint64_t num_records)
+{
+    txn_log_header header;
+    fill_header(&header, num_accounts, num_records);
+
+    if (fseek(out, 0, SEEK_SET) != 0) {
+        return -1;
+    }
+    return fwrite(&header, sizeof(header), 1, out) == 1 ? 0 : -1;
+}
+
+static int valid_record(const txn_record* record, int num_accounts)
+{
+    if (record->type != 'D' && record->type != 'W' && record->type != 'T' && record->type != 'C') {
+        return 0;
+    }
+    if (record->src < -1 || record->src >= num_accounts) {
+        return 0;
+    }
+    return record->dest >= -1 && record->dest < num_accounts;
+}
+
+int txn_log_open(txn_log* log, const char* path, int num_accounts)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(txn_log_header)) {
+        close(fd);
+        return -1;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    const txn_log_header* header = map;
+    size_t body = st.st_size - sizeof(txn_log_header);
+    if (memcmp(header->magic, TXN_LOG_MAGIC, sizeof(TXN_LOG_MAGIC)) != 0 ||
+        header->version != TXN_LOG_VERSION ||
+        header->num_accounts != (uint32_t)num_accounts ||
+        header->num_records > body / sizeof(txn_record)) {
+        munmap(map, st.st_size);
+        return -1;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    // workers index the account arrays with src and dest unchecked, so every
+    // record is validated once here rather than at each claim
+    const txn_record* records = (const txn_record*)(header + 1);
+    for (uint64_t i = 0; i < header->num_records; i++) {
+        if (!valid_record(&records[i], num_accounts)) {
+            munmap(map, st.st_size);
+            return -1;
+        }
+    }
+
+    log->map = map;
+    log->map_size = st.st_size;
+    log->records = records;
+    log->num_records = header->num_records;
+    log->end_record = log->num_records;
+    atomic_init(&log->next_record, 0);
+    return 0;
+}
+
+size_t txn_log_claim(txn_log* log, const txn_record** first)
+{
+    size_t start = atomic_fetch_add_explicit(&log->next_record, TXN_LOG_BATCH, memory_order_relaxed);
+    if (start >= log->end_record) {
+        return 0;
+    }
+
+    *first = log->records + start;
+    return log->end_record - start < TXN_LOG_BATCH ? log->end_record - start : TXN_LOG_BATCH;
+}
+
+void txn_log_segment(txn_log* log, size_t first, size_t end)
+{
+    log->end_record = end < log->num_records ? end : log->num_records;
+    atomic_store(&log->next_record, first);
+}
+
+void txn_record_to_transaction(const txn_record* record, transaction* txn)
+{
+    txn->type = record->type;
+    txn->authorized = (record->flags & TXN_AUTHORIZED) != 0;
+    txn->src = record->src;
+    txn->dest = record->dest;
+    txn->amount = money_from_cents(record->amount);
+}
+
+void txn_log_close(txn_log* log)
+{
+    if (log == NULL) return;
+
+    if (log->map != NULL) {
+        munmap(log->map, log->map_size);
+        log->map = NULL;
+    }
+    log->records = NULL;
+    log->num_records = 0;
+}
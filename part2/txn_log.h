@@ -0,0 +1,65 @@
+#ifndef TXN_LOG_H_
+#define TXN_LOG_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "transaction.h"
+
+#define TXN_LOG_MAGIC "DUCKTXN"
+#define TXN_LOG_VERSION 1
+#define TXN_LOG_BATCH 4096          // records a worker claims at a time
+
+#define TXN_AUTHORIZED 0x01
+
+//compiled transaction file: one txn_log_header followed by num_records
+//fixed-width records, all fields in host byte order
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_accounts;      // accounts in the header the log was compiled against
+    uint64_t num_records;
+}txn_log_header;
+
+typedef struct
+{
+    int64_t amount;             // integer cents
+    int32_t src;                // account index, -1 when unknown
+    int32_t dest;               // account index for transfers, -1 otherwise
+    uint8_t type;               // 'D', 'W', 'T' or 'C'
+    uint8_t flags;              // TXN_AUTHORIZED
+    uint8_t reserved[6];
+}txn_record;
+
+//a compiled log mapped for replay, workers claim TXN_LOG_BATCH records at a time
+typedef struct
+{
+    void* map;
+    size_t map_size;
+    const txn_record* records;
+    size_t num_records;
+    size_t end_record;          // claims stop here, the end of the current checkpoint segment
+    atomic_size_t next_record;
+}txn_log;
+
+//writes a placeholder header, call txn_log_finish once every record is written
+int txn_log_begin(FILE* out, int num_accounts);
+int txn_log_append(FILE* out, const transaction* txn);
+int txn_log_finish(FILE* out, int num_accounts, uint64_t num_records);
+
+//maps a compiled log and checks it was built for num_accounts accounts
+int txn_log_open(txn_log* log, const char* path, int num_accounts);
+
+//claims the next batch of records, returns how many (0 when the log is used up)
+size_t txn_log_claim(txn_log* log, const txn_record** first);
+
+//restricts claims to records [first, end), only while no worker replays
+void txn_log_segment(txn_log* log, size_t first, size_t end);
+
+void txn_record_to_transaction(const txn_record* record, transaction* txn);
+
+void txn_log_close(txn_log* log);
+
+#endif /* TXN_LOG_H_ */
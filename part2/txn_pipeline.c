@@ -0,0 +1,79 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "txn_pipeline.h"
+
+int txn_pipeline_init(txn_pipeline* pipeline, int num_parsers, int num_executors)
+{
+    size_t size = sizeof(txn_queue) * num_parsers * num_executors;
+
+    pipeline->queues = aligned_alloc(CACHE_LINE, size);
+    if (pipeline->queues == NULL) {
+        return -1;
+    }
+    memset(pipeline->queues, 0, size);
+    pipeline->num_parsers = num_parsers;
+    pipeline->num_executors = num_executors;
+    return 0;
+}
+
+txn_queue* txn_pipeline_queue(txn_pipeline* pipeline, int parser, int executor)
+{
+    return &pipeline->queues[parser * pipeline->num_executors + executor];
+}
+
+void txn_pipeline_free(txn_pipeline* pipeline)
+{
+    free(pipeline->queues);
+    pipeline->queues = NULL;
+}
+
+txn_batch* txn_queue_reserve(txn_queue* queue)
+{
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    // the consumer is behind by a whole ring, a slow executor holds its parsers back
+    while (tail - atomic_load_explicit(&queue->head, memory_order_acquire) == PIPELINE_SLOTS) {
+        sched_yield();
+    }
+    txn_batch* batch = &queue->slots[tail & (PIPELINE_SLOTS - 1)];
+    batch->count = 0;
+    return batch;
+}
+
+void txn_queue_publish(txn_queue* queue)
+{
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+}
+
+void txn_queue_close(txn_queue* queue)
+{
+    atomic_store_explicit(&queue->closed, 1, memory_order_release);
+}
+
+txn_batch* txn_queue_peek(txn_queue* queue)
+{
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    if (head == atomic_load_explicit(&queue->tail, memory_order_acquire)) {
+        return NULL;
+    }
+    return &queue->slots[head & (PIPELINE_SLOTS - 1)];
+}
+
+void txn_queue_release(txn_queue* queue)
+{
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+}
+
+int txn_queue_drained(txn_queue* queue)
+{
+    // closed is set after the last publish, so once it is seen the tail is final
+    if (!atomic_load_explicit(&queue->closed, memory_order_acquire)) {
+        return 0;
+    }
+    return atomic_load_explicit(&queue->head, memory_order_relaxed) ==
+           atomic_load_explicit(&queue->tail, memory_order_acquire);
+}
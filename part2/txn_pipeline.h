@@ -0,0 +1,68 @@
+#ifndef TXN_PIPELINE_H_
+#define TXN_PIPELINE_H_
+
+#include <stdatomic.h>
+#include "transaction.h"
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#define PIPELINE_BATCH 256              // transactions a parser hands over at a time
+#define PIPELINE_SLOTS 8                // batches in flight per queue, power of two
+
+//parsed transactions with their accounts already looked up, only ones that
+//can change or read an account
+typedef struct
+{
+    int count;
+    transaction txns[PIPELINE_BATCH];
+}txn_batch;
+
+//single-producer single-consumer ring of batches. Batches are filled and read
+//in place, the producer owns the slots in [tail, head + SLOTS) and the consumer
+//the ones in [head, tail). Each counter is only written by its own side.
+typedef struct
+{
+    atomic_uint head __attribute__((aligned(CACHE_LINE)));     // next batch the consumer reads
+    atomic_uint tail __attribute__((aligned(CACHE_LINE)));     // next batch the producer fills
+    atomic_int closed;                                          // the producer is done
+    txn_batch slots[PIPELINE_SLOTS] __attribute__((aligned(CACHE_LINE)));
+}txn_queue;
+
+//Parser threads feed executor threads over a queue per (parser, executor)
+//pair, so every queue has one producer and one consumer and needs no lock. A
+//parser deals its batches out to the executors in turn, an executor polls the
+//queues of every parser.
+typedef struct
+{
+    txn_queue* queues;          // parser-major
+    int num_parsers;
+    int num_executors;
+}txn_pipeline;
+
+int txn_pipeline_init(txn_pipeline* pipeline, int num_parsers, int num_executors);
+
+txn_queue* txn_pipeline_queue(txn_pipeline* pipeline, int parser, int executor);
+
+void txn_pipeline_free(txn_pipeline* pipeline);
+
+//producer: an empty batch to fill, waits while the consumer has every slot
+txn_batch* txn_queue_reserve(txn_queue* queue);
+
+//producer: hands the reserved batch over
+void txn_queue_publish(txn_queue* queue);
+
+//producer: no more batches will come
+void txn_queue_close(txn_queue* queue);
+
+//consumer: the oldest published batch, NULL if there is none yet
+txn_batch* txn_queue_peek(txn_queue* queue);
+
+//consumer: done with the batch peek returned, its slot goes back to the producer
+void txn_queue_release(txn_queue* queue);
+
+//consumer: whether the producer closed the queue and every batch was read
+int txn_queue_drained(txn_queue* queue);
+
+#endif /* TXN_PIPELINE_H_ */
@@ -0,0 +1,196 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <signal.h>
+#include "worker_stats.h"
+
+#ifdef WORKER_STATS
+
+static const char* command_names[STATS_COMMANDS] = {"deposit", "withdraw", "transfer", "check"};
+
+static worker_stats* slots;
+static int num_slots;
+static pthread_t dump_thread;
+static volatile sig_atomic_t finishing;
+
+static uint64_t load(const uint64_t* counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+// A latency bound such as 512ns, 4.1us or 2.0ms
+static void format_ns(char* text, size_t size, uint64_t ns)
+{
+    if (ns < 10000) {
+        snprintf(text, size, "%lluns", (unsigned long long)ns);
+    } else if (ns < 1000000) {
+        snprintf(text, size, "%.1fus", ns / 1e3);
+    } else {
+        snprintf(text, size, "%.1fms", ns / 1e6);
+    }
+}
+
+// The upper bound of the bucket holding the q-th quantile of the histogram
+static uint64_t quantile_bound(const uint64_t* histogram, uint64_t count, double q)
+{
+    uint64_t seen = 0;
+    uint64_t target = (uint64_t)(count * q);
+
+    for (int b = 0; b < STATS_BUCKETS; b++) {
+        seen += histogram[b];
+        if (seen > target) {
+            return 2ULL << b;
+        }
+    }
+    return 2ULL << (STATS_BUCKETS - 1);
+}
+
+static void print_worker(FILE* out, const char* name, const worker_stats* stats)
+{
+    fprintf(out, "%6s %12llu %10llu %10llu %10llu %10llu %12llu %13.3f %16.3f\n", name,
+            (unsigned long long)stats->lines,
+            (unsigned long long)stats->commands[STATS_DEPOSIT], (unsigned long long)stats->commands[STATS_WITHDRAW],
+            (unsigned long long)stats->commands[STATS_TRANSFER], (unsigned long long)stats->commands[STATS_CHECK],
+            (unsigned long long)stats->failed_auth, stats->file_wait_ns / 1e6, stats->account_wait_ns / 1e6);
+}
+
+// Copies a slot field by field, a worker may be writing it meanwhile
+static void copy_slot(worker_stats* copy, const worker_stats* slot)
+{
+    const uint64_t* from = (const uint64_t*)slot;
+    uint64_t* to = (uint64_t*)copy;
+
+    memset(copy, 0, sizeof(*copy));
+    for (size_t i = 0; i < offsetof(worker_stats, latency) / sizeof(uint64_t) + STATS_COMMANDS * STATS_BUCKETS; i++) {
+        to[i] = load(&from[i]);
+    }
+}
+
+void worker_stats_print(FILE* out)
+{
+    worker_stats total, copy;
+    char name[16];
+
+    memset(&total, 0, sizeof(total));
+    fprintf(out, "worker        lines   deposits  withdraws  transfers     checks  failed_auth  file_wait_ms  account_wait_ms\n");
+    for (int w = 0; w < num_slots; w++) {
+        copy_slot(&copy, &slots[w]);
+        snprintf(name, sizeof(name), "%d", w);
+        print_worker(out, name, &copy);
+
+        uint64_t* sum = (uint64_t*)&total;
+        const uint64_t* add = (const uint64_t*)&copy;
+        for (size_t i = 0; i < offsetof(worker_stats, latency) / sizeof(uint64_t) + STATS_COMMANDS * STATS_BUCKETS; i++) {
+            sum[i] += add[i];
+        }
+    }
+    print_worker(out, "all", &total);
+
+    fprintf(out, "latency        count       p50       p90       p99       max    (log2 bucket upper bounds)\n");
+    for (int c = 0; c < STATS_COMMANDS; c++) {
+        const uint64_t* histogram = total.latency[c];
+        uint64_t count = 0;
+        int last = 0;
+        char p50[16], p90[16], p99[16], max[16];
+
+        for (int b = 0; b < STATS_BUCKETS; b++) {
+            count += histogram[b];
+            if (histogram[b] > 0) {
+                last = b;
+            }
+        }
+        if (count == 0) {
+            continue;
+        }
+        format_ns(p50, sizeof(p50), quantile_bound(histogram, count, 0.5));
+        format_ns(p90, sizeof(p90), quantile_bound(histogram, count, 0.9));
+        format_ns(p99, sizeof(p99), quantile_bound(histogram, count, 0.99));
+        format_ns(max, sizeof(max), 2ULL << last);
+        fprintf(out, "%-8s %12llu %9s %9s %9s %9s\n", command_names[c], (unsigned long long)count, p50, p90, p99, max);
+
+        // the histogram itself, one "lower bound:count" pair per non-empty bucket
+        fprintf(out, "        ");
+        for (int b = 0; b < STATS_BUCKETS; b++) {
+            if (histogram[b] > 0) {
+                char bound[16];
+                format_ns(bound, sizeof(bound), b > 0 ? 1ULL << b : 0);
+                fprintf(out, " %s:%llu", bound, (unsigned long long)histogram[b]);
+            }
+        }
+        fprintf(out, "\n");
+    }
+    fflush(out);
+}
+
+// Waits for SIGUSR1 and dumps, printing from a normal thread rather than from a
+// signal handler. worker_stats_finish wakes it with a last SIGUSR1 of its own.
+static void* dump_on_signal(void* arg)
+{
+    sigset_t* signals = (sigset_t*)arg;
+    int signal;
+
+    while (sigwait(signals, &signal) == 0 && !finishing) {
+        fprintf(stderr, "--- worker stats (SIGUSR1) ---\n");
+        worker_stats_print(stderr);
+    }
+    return NULL;
+}
+
+int worker_stats_start(int num_workers)
+{
+    static sigset_t signals;
+
+    slots = aligned_alloc(64, sizeof(worker_stats) * num_workers);
+    if (slots == NULL) {
+        return -1;
+    }
+    memset(slots, 0, sizeof(worker_stats) * num_workers);
+    num_slots = num_workers;
+
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    return pthread_create(&dump_thread, NULL, dump_on_signal, &signals) == 0 ? 0 : -1;
+}
+
+worker_stats* worker_stats_slot(int worker)
+{
+    return &slots[worker];
+}
+
+void worker_stats_finish(void)
+{
+    finishing = 1;
+    pthread_kill(dump_thread, SIGUSR1);
+    pthread_join(dump_thread, NULL);
+
+    fprintf(stderr, "--- worker stats ---\n");
+    worker_stats_print(stderr);
+    free(slots);
+    slots = NULL;
+}
+
+#else
+
+int worker_stats_start(int num_workers)
+{
+    (void)num_workers;
+    return 0;
+}
+
+worker_stats* worker_stats_slot(int worker)
+{
+    (void)worker;
+    return NULL;
+}
+
+void worker_stats_print(FILE* out)
+{
+    (void)out;
+}
+
+void worker_stats_finish(void)
+{
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef WORKER_STATS_H_
+#define WORKER_STATS_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+//Per-worker counters and latency histograms, built only with -DWORKER_STATS
+//(make WORKER_STATS=1). Without it the STATS_* macros below expand to nothing,
+//or to the plain pthread_mutex_lock, and the rest of the API does nothing, so
+//the default build pays nothing for them.
+//
+//Each worker writes only its own slot, with plain loads and stores (relaxed
+//atomics so a dump from another thread reads untorn values), never a shared
+//read-modify-write. A dump sums the slots: at exit, and whenever the process
+//gets SIGUSR1 while the workers run.
+
+#define STATS_BUCKETS 40        // bucket b counts latencies in [2^b, 2^(b+1)) ns, the last one everything above
+
+enum
+{
+    STATS_DEPOSIT,
+    STATS_WITHDRAW,
+    STATS_TRANSFER,
+    STATS_CHECK,
+    STATS_COMMANDS
+};
+
+typedef struct worker_stats worker_stats;
+
+#ifdef WORKER_STATS
+
+#include <time.h>
+
+struct worker_stats
+{
+    uint64_t lines;                     // transaction lines (or compiled records) the worker parsed
+    uint64_t commands[STATS_COMMANDS];
+    uint64_t failed_auth;               // commands whose password did not match, or for an unknown account
+    uint64_t file_wait_ns;              // blocked on file_mutex
+    uint64_t account_wait_ns;           // blocked on per-account locks
+    uint64_t latency[STATS_COMMANDS][STATS_BUCKETS];    // parse and apply time per command
+} __attribute__((aligned(64)));
+
+static inline void worker_stats_add(uint64_t* counter, uint64_t n)
+{
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static inline int64_t worker_stats_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline int worker_stats_command(char type)
+{
+    return type == 'D' ? STATS_DEPOSIT : type == 'W' ? STATS_WITHDRAW : type == 'T' ? STATS_TRANSFER : STATS_CHECK;
+}
+
+//only a lock that is already taken gets timed, an uncontended one costs a trylock
+static inline void worker_stats_lock(uint64_t* wait_ns, pthread_mutex_t* mutex)
+{
+    if (pthread_mutex_trylock(mutex) != 0) {
+        int64_t start = worker_stats_now();
+        pthread_mutex_lock(mutex);
+        worker_stats_add(wait_ns, worker_stats_now() - start);
+    }
+}
+
+static inline void worker_stats_latency(worker_stats* stats, char type, int64_t start)
+{
+    uint64_t ns = worker_stats_now() - start;
+    int bucket = ns > 1 ? 63 - __builtin_clzll(ns) : 0;
+
+    if (bucket >= STATS_BUCKETS) {
+        bucket = STATS_BUCKETS - 1;
+    }
+    worker_stats_add(&stats->latency[worker_stats_command(type)][bucket], 1);
+}
+
+#define STATS_COUNT(stats, field) worker_stats_add(&(stats)->field, 1)
+#define STATS_COMMAND(stats, txn) do { \
+        worker_stats_add(&(stats)->commands[worker_stats_command((txn)->type)], 1); \
+        if (!(txn)->authorized) worker_stats_add(&(stats)->failed_auth, 1); \
+    } while (0)
+#define STATS_START(name) int64_t name = worker_stats_now()
+#define STATS_LATENCY(stats, type, start) worker_stats_latency(stats, type, start)
+#define STATS_LOCK(stats, field, mutex) worker_stats_lock(&(stats)->field, mutex)
+
+#else
+
+#define STATS_COUNT(stats, field) ((void)0)
+#define STATS_COMMAND(stats, txn) ((void)0)
+#define STATS_START(name)
+#define STATS_LATENCY(stats, type, start) ((void)0)
+#define STATS_LOCK(stats, field, mutex) ((void)(stats), pthread_mutex_lock(mutex))
+
+#endif
+
+//allocates a zeroed slot per worker and starts the thread that dumps them on
+//SIGUSR1. SIGUSR1 is blocked in the calling thread, so call it before creating
+//the threads that inherit the mask. Returns 0 on success.
+int worker_stats_start(int num_workers);
+
+//the worker's slot, NULL without WORKER_STATS
+worker_stats* worker_stats_slot(int worker);
+
+//prints the totals, every worker's counters and the latency histograms
+void worker_stats_print(FILE* out);
+
+//stops the SIGUSR1 thread, prints a final dump to stderr and frees the slots
+void worker_stats_finish(void);
+
+#endif /* WORKER_STATS_H_ */